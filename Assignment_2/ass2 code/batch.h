@@ -0,0 +1,38 @@
+/* * * * * * * * *
+ * Helpers shared by the batched insert/lookup functions of each hash table:
+ * result bitmaps and software prefetching of table memory
+ *
+ * created for COMP20007 Design of Algorithms - Assignment 2, 2017
+ * by Max Philip
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdint.h>
+
+// how many keys ahead of the current key a batched operation hashes and
+// prefetches. large enough to cover a memory access with useful work, small
+// enough that the prefetched lines are still in cache when we get to them
+#define BATCH_WINDOW 16
+
+// hint to the processor that the memory at address 'p' will be read soon
+// (no-op for compilers without the gcc/clang builtin)
+#if defined(__GNUC__)
+#define prefetch(p) __builtin_prefetch((p), 0, 1)
+#else
+#define prefetch(p) ((void)(p))
+#endif
+
+// number of bytes needed for a result bitmap holding 'n' bits
+#define bitmap_bytes(n) (((n) + 7) / 8)
+
+// set bit 'i' of 'bitmap' to 'value' (true or false)
+#define bitmap_set(bitmap, i, value) \
+	((value) ? ((bitmap)[(i) / 8] |=  (uint8_t)(1 << ((i) % 8))) \
+	         : ((bitmap)[(i) / 8] &= (uint8_t)~(1 << ((i) % 8))))
+
+// get bit 'i' of 'bitmap' (as 1 or 0)
+#define bitmap_get(bitmap, i) (((bitmap)[(i) / 8] >> ((i) % 8)) & 1)
+
+#endif
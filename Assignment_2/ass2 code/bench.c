@@ -0,0 +1,432 @@
+/* * * * * * * * *
+ * Utility program that benchmarks the hash tables through the unified
+ * interface in hashtbl.h, using randomly generated keys
+ *
+ * usage:
+ *   make bench
+ *   ./bench mode type nkeys [size [options]]
+ *       mode:    which benchmark to run (see below)
+ *       type:    hash table type, as for the a2 program's -t option
+ *       nkeys:   number of keys to insert (and then look up)
+ *       size:    initial table size, as for the a2 program's -s option
+ *       options: table options, as for the a2 program's -o option
+ *
+ * modes:
+ *   batch: keys/sec for single-key vs. batched inserts and lookups
+ *   hash:  keys/sec for scalar h1/h2 vs. the multi-key (SIMD) h1_multi/h2_multi
+ *          (type and size are ignored)
+ *   layout: keys/sec for the linear table with an in-use flag array vs.
+ *           sentinel-marked empty slots (type is ignored)
+ *   latency: per-insert latency percentiles for the linear table with
+ *            stop-the-world vs. incremental resizing, or for the extendible
+ *            tables (xtndbl1, xtndbln, xuckoo, xuckoon) with an eager vs. lazy
+ *            directory (any other type means linear)
+ *   memory: peak resident memory while growing a table to nkeys keys
+ *   fill: load factor a table of nkeys slots (per inner table, for cuckoo and
+ *         cuckoo3) reaches before it first has to grow, over FILL_TRIALS
+ *         tables (only for the tables with a fixed number of slots: linear,
+ *         cuckoo, cuckoo3, swiss). with the default options (no stash, no
+ *         load limit), a cuckoo table only grows when an insertion fails
+ *
+ * created for COMP20007 Design of Algorithms - Assignment 2, 2017
+ * by Max Philip
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#include "inthash.h"
+#include "hashtbl.h"
+
+#define DEFAULT_SIZE 4
+
+/* how many tables fill mode fills */
+#define FILL_TRIALS 20
+
+/*************************************************************************/
+
+void printusageexit(char *exe) {
+	/* Print usage information: */
+	fprintf(stderr, "usage: %s mode type nkeys [size [options]]\n", exe);
+	fprintf(stderr, " mode: benchmark to run, one of:\n");
+	fprintf(stderr, "   batch: single-key vs. batched insert and lookup\n");
+	fprintf(stderr, "   hash: scalar vs. multi-key (SIMD) hashing\n");
+	fprintf(stderr, "   layout: linear table in-use flags vs. sentinel keys\n");
+	fprintf(stderr, "   latency: linear table stop-the-world vs. incremental"
+		" resizing, or extendible table eager vs. lazy directory\n");
+	fprintf(stderr, "   memory: peak resident memory while growing a table\n");
+	fprintf(stderr, "   fill: load factor at which a table of nkeys slots"
+		" first grows (for a cuckoo table: first fails to insert)\n");
+	fprintf(stderr, " type: hash table type (as for a2 -t)\n");
+	fprintf(stderr, " nkeys: number of keys to insert and look up\n");
+	fprintf(stderr, " size: initial table size (as for a2 -s, default %d)\n",
+		DEFAULT_SIZE);
+	fprintf(stderr, " options: table options (as for a2 -o), one of:\n");
+	print_table_options(stderr);
+
+	/* and exit, as promised :) */
+	exit(1);
+}
+
+/*************************************************************************/
+
+/* Return a random 64-bit number (rand() alone only gives 31 bits). */
+int64 rand64() {
+	return ((int64)rand() << 42) ^ ((int64)rand() << 21) ^ (int64)rand();
+}
+
+/* Fill 'keys' with 'n' distinct-ish random keys to insert. */
+void random_keys(int64 *keys, int n) {
+	int i;
+	for (i = 0; i < n; i++) {
+		keys[i] = rand64();
+	}
+}
+
+/* Fill 'lookups' with 'n' keys to look up: like cmdgen, flip a coin to decide
+ * whether to use one of the 'ninserts' existing keys or a new one. */
+void random_lookups(int64 *lookups, int n, int64 *inserts, int ninserts) {
+	int i;
+	for (i = 0; i < n; i++) {
+		if (rand() % 2) {
+			lookups[i] = inserts[rand() % ninserts];
+		} else {
+			lookups[i] = rand64();
+		}
+	}
+}
+
+/* Convert a number of keys processed in 'ticks' clock ticks to keys/sec. */
+double keys_per_sec(int n, clock_t ticks) {
+	double seconds = ticks * 1.0 / CLOCKS_PER_SEC;
+	return seconds > 0 ? n / seconds : 0;
+}
+
+/* Return the current time in nanoseconds, from a monotonic clock (for timing
+ * single operations, which clock() is far too coarse for). */
+long long now_ns() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* Comparison function for sorting latencies with qsort. */
+int cmp_latency(const void *a, const void *b) {
+	long long x = *(const long long *)a, y = *(const long long *)b;
+	return (x > y) - (x < y);
+}
+
+/* Return the 'p'th percentile of the 'n' sorted latencies in 'sorted'. */
+long long percentile(long long *sorted, int n, double p) {
+	int i = p / 100 * n;
+	return sorted[i < n ? i : n - 1];
+}
+
+/* Return the peak resident set size of this process so far, in megabytes. */
+double peak_rss_mb() {
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss / 1024.0;	/* ru_maxrss is in kilobytes */
+}
+
+/*************************************************************************/
+
+/* batch mode: compare single-key and batched inserts and lookups */
+void bench_batch(TableType type, int nkeys, int size,
+	TableOptions *options) {
+	int64 *inserts = malloc(sizeof (int64) * nkeys);
+	int64 *lookups = malloc(sizeof (int64) * nkeys);
+	uint8_t *results = malloc(bitmap_bytes(nkeys));
+	random_keys(inserts, nkeys);
+	random_lookups(lookups, nkeys, inserts, nkeys);
+
+	int i, ninserted = 0, nfound = 0;
+	clock_t start;
+
+	/* Single-key path. */
+	HashTable *table = new_hash_table(type, size, options);
+	start = clock();
+	for (i = 0; i < nkeys; i++) {
+		ninserted += hash_table_insert(table, inserts[i]);
+	}
+	clock_t single_insert = clock() - start;
+	start = clock();
+	for (i = 0; i < nkeys; i++) {
+		nfound += hash_table_lookup(table, lookups[i]);
+	}
+	clock_t single_lookup = clock() - start;
+	free_hash_table(table);
+
+	/* Batched path, on an identical fresh table. */
+	table = new_hash_table(type, size, options);
+	start = clock();
+	int batch_inserted = hash_table_insert_batch(table, inserts, nkeys, results);
+	clock_t batch_insert = clock() - start;
+	start = clock();
+	int batch_found = hash_table_lookup_batch(table, lookups, nkeys, results);
+	clock_t batch_lookup = clock() - start;
+	free_hash_table(table);
+
+	if (batch_inserted != ninserted || batch_found != nfound) {
+		fprintf(stderr, "error: batched results differ from single-key "
+			"results (%d/%d inserted, %d/%d found)\n",
+			batch_inserted, ninserted, batch_found, nfound);
+	}
+
+	printf("                 single-key      batched  speedup\n");
+	printf("insert keys/sec: %12.0f %12.0f  %6.2fx\n",
+		keys_per_sec(nkeys, single_insert), keys_per_sec(nkeys, batch_insert),
+		single_insert * 1.0 / (batch_insert ? batch_insert : 1));
+	printf("lookup keys/sec: %12.0f %12.0f  %6.2fx\n",
+		keys_per_sec(nkeys, single_lookup), keys_per_sec(nkeys, batch_lookup),
+		single_lookup * 1.0 / (batch_lookup ? batch_lookup : 1));
+
+	free(inserts);
+	free(lookups);
+	free(results);
+}
+
+/* hash mode: compare scalar and multi-key hash function throughput */
+void bench_hash(int nkeys) {
+	int64 *keys = malloc(sizeof (int64) * nkeys);
+	int *hashes1 = malloc(sizeof (int) * nkeys);
+	int *hashes2 = malloc(sizeof (int) * nkeys);
+	random_keys(keys, nkeys);
+
+	int i, mismatches = 0;
+	clock_t start;
+
+	/* Scalar: one key at a time. */
+	start = clock();
+	for (i = 0; i < nkeys; i++) {
+		hashes1[i] = h1(keys[i]);
+		hashes2[i] = h2(keys[i]);
+	}
+	clock_t scalar = clock() - start;
+
+	/* Multi-key kernels, checked against the scalar results. */
+	int *multi1 = malloc(sizeof (int) * nkeys);
+	int *multi2 = malloc(sizeof (int) * nkeys);
+	start = clock();
+	h1_multi(keys, nkeys, multi1);
+	h2_multi(keys, nkeys, multi2);
+	clock_t multi = clock() - start;
+	for (i = 0; i < nkeys; i++) {
+		mismatches += multi1[i] != hashes1[i] || multi2[i] != hashes2[i];
+	}
+	if (mismatches > 0) {
+		fprintf(stderr, "error: %d keys hashed differently\n", mismatches);
+	}
+
+	printf("multi-key kernel: %s\n", hash_multi_kernel());
+	printf("             scalar     multi-key  speedup\n");
+	printf("keys/sec: %12.0f %12.0f  %6.2fx\n",
+		keys_per_sec(nkeys, scalar), keys_per_sec(nkeys, multi),
+		scalar * 1.0 / (multi ? multi : 1));
+
+	free(keys);
+	free(hashes1);
+	free(hashes2);
+	free(multi1);
+	free(multi2);
+}
+
+/* layout mode: compare the linear table's slot layouts */
+void bench_layout(int nkeys, int size, TableOptions *options) {
+	int64 *inserts = malloc(sizeof (int64) * nkeys);
+	int64 *lookups = malloc(sizeof (int64) * nkeys);
+	random_keys(inserts, nkeys);
+	random_lookups(lookups, nkeys, inserts, nkeys);
+
+	printf("          insert keys/sec  lookup keys/sec  found\n");
+
+	/* Run the same keys through both layouts. */
+	int layout;
+	for (layout = 0; layout < 2; layout++) {
+		TableOptions layout_options = *options;
+		layout_options.sentinel = layout;
+		HashTable *table = new_hash_table(LINEAR, size, &layout_options);
+
+		int i, nfound = 0;
+		clock_t start = clock();
+		for (i = 0; i < nkeys; i++) {
+			hash_table_insert(table, inserts[i]);
+		}
+		clock_t insert = clock() - start;
+		start = clock();
+		for (i = 0; i < nkeys; i++) {
+			nfound += hash_table_lookup(table, lookups[i]);
+		}
+		clock_t lookup = clock() - start;
+		free_hash_table(table);
+
+		printf("%-9s %15.0f  %15.0f  %d\n", layout ? "sentinel" : "inuse",
+			keys_per_sec(nkeys, insert), keys_per_sec(nkeys, lookup), nfound);
+	}
+
+	free(inserts);
+	free(lookups);
+}
+
+/* latency mode: compare the distribution of single-insert latencies for the
+ * linear table's stop-the-world and incremental resizing, or for an extendible
+ * table's eagerly and lazily doubled directory */
+void bench_latency(TableType type, int nkeys, int size, TableOptions *options) {
+	bool directory = type == XTNDBL1 || type == XTNDBLN || type == XUCKOO
+		|| type == XUCKOON;
+	if (!directory) {
+		type = LINEAR;
+	}
+
+	int64 *inserts = malloc(sizeof (int64) * nkeys);
+	long long *latencies = malloc(sizeof (long long) * nkeys);
+	random_keys(inserts, nkeys);
+
+	printf("insert latency (ns)      p50      p99    p99.9   p99.99"
+		"        max     total\n");
+
+	/* Run the same keys through both resizing modes. */
+	int mode;
+	for (mode = 0; mode < 2; mode++) {
+		TableOptions mode_options = *options;
+		if (directory) {
+			mode_options.lazy_directory = mode == 1;
+		} else if (mode == 0) {
+			mode_options.migrate = 0;
+		} else if (mode_options.migrate == 0) {
+			/* as for a bare '-o incremental' */
+			parse_table_options("incremental", &mode_options);
+		}
+		HashTable *table = new_hash_table(type, size, &mode_options);
+
+		int i;
+		long long total = 0;
+		for (i = 0; i < nkeys; i++) {
+			long long start = now_ns();
+			hash_table_insert(table, inserts[i]);
+			latencies[i] = now_ns() - start;
+			total += latencies[i];
+		}
+		free_hash_table(table);
+
+		qsort(latencies, nkeys, sizeof *latencies, cmp_latency);
+		char *names[2][2] = {{"stop-the-world", "incremental"},
+			{"eager directory", "lazy directory"}};
+		printf("%-19s %8lld %8lld %8lld %8lld %10lld %9.3fs\n",
+			names[directory][mode],
+			percentile(latencies, nkeys, 50), percentile(latencies, nkeys, 99),
+			percentile(latencies, nkeys, 99.9),
+			percentile(latencies, nkeys, 99.99), latencies[nkeys - 1],
+			total / 1e9);
+	}
+
+	free(inserts);
+	free(latencies);
+}
+
+/* memory mode: grow a table from 'size' to 'nkeys' keys, generating the keys
+ * as we go so that the only large allocations are the table's own */
+void bench_memory(TableType type, int nkeys, int size, TableOptions *options) {
+	double start_rss = peak_rss_mb();
+
+	HashTable *table = new_hash_table(type, size, options);
+	int i, ninserted = 0;
+	clock_t start = clock();
+	for (i = 0; i < nkeys; i++) {
+		ninserted += hash_table_insert(table, rand64());
+	}
+	clock_t insert = clock() - start;
+	double peak_rss = peak_rss_mb();
+	free_hash_table(table);
+
+	printf("inserted: %d keys in %.2f sec\n", ninserted,
+		insert * 1.0 / CLOCKS_PER_SEC);
+	printf("peak rss: %.1f MB (%.1f MB before the table)\n", peak_rss,
+		start_rss);
+	printf("per key:  %.2f bytes\n",
+		(peak_rss - start_rss) * 1024 * 1024 / ninserted);
+}
+
+/* fill mode: insert random keys into tables of 'nkeys' slots until each
+ * first has to grow, and report the load factor each reached before then */
+void bench_fill(TableType type, int nkeys, TableOptions *options) {
+	double total = 0, lowest = 1, highest = 0;
+	int capacity = 0;
+
+	int trial;
+	for (trial = 0; trial < FILL_TRIALS; trial++) {
+		HashTable *table = new_hash_table(type, nkeys, options);
+		capacity = hash_table_capacity(table);
+		if (capacity == 0) {
+			fprintf(stderr, "error: fill mode needs a table with a fixed"
+				" number of slots (linear, cuckoo, cuckoo3 or swiss)\n");
+			exit(1);
+		}
+
+		/* the insertion that makes the table grow doesn't count */
+		int ninserted = 0;
+		while (hash_table_capacity(table) == capacity) {
+			ninserted += hash_table_insert(table, rand64());
+		}
+		free_hash_table(table);
+
+		double fill = (ninserted - 1) * 1.0 / capacity;
+		total += fill;
+		lowest = fill < lowest ? fill : lowest;
+		highest = fill > highest ? fill : highest;
+	}
+
+	printf("load factor before first growth, %d tables of %d slots:\n",
+		FILL_TRIALS, capacity);
+	printf("mean %.2f%%  min %.2f%%  max %.2f%%\n", total * 100 / FILL_TRIALS,
+		lowest * 100, highest * 100);
+}
+
+/*************************************************************************/
+
+int main(int argc, char **argv) {
+
+	/* Get command line arguments. */
+	if (argc < 4) {
+		printusageexit(argv[0]);
+	}
+	char *mode = argv[1];
+	TableType type = strtotype(argv[2]);
+	int nkeys = atoi(argv[3]);
+	int size = argc > 4 ? atoi(argv[4]) : DEFAULT_SIZE;
+	TableOptions options;
+	default_table_options(&options);
+	if (argc > 5 && !parse_table_options(argv[5], &options)) {
+		printusageexit(argv[0]);
+	}
+	if (type == NOTYPE || nkeys <= 0 || size <= 0) {
+		printusageexit(argv[0]);
+	}
+
+	/* Seed the random number generator. */
+	srand(time(NULL));
+
+	/* Run the requested benchmark. */
+	if (strcmp(mode, "batch") == 0) {
+		bench_batch(type, nkeys, size, &options);
+	} else if (strcmp(mode, "hash") == 0) {
+		bench_hash(nkeys);
+	} else if (strcmp(mode, "layout") == 0) {
+		bench_layout(nkeys, size, &options);
+	} else if (strcmp(mode, "latency") == 0) {
+		bench_latency(type, nkeys, size, &options);
+	} else if (strcmp(mode, "memory") == 0) {
+		bench_memory(type, nkeys, size, &options);
+	} else if (strcmp(mode, "fill") == 0) {
+		bench_fill(type, nkeys, &options);
+	} else {
+		printusageexit(argv[0]);
+	}
+
+	return 0;
+}
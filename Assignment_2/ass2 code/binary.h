@@ -0,0 +1,31 @@
+/* * * * * * * * *
+ * Format of packed binary command files, as written by 'cmdgen -b' and
+ * executed by 'a2 -b file'
+ *
+ * a binary command file is a sequence of fixed-size records with no header
+ * and no padding. each record is one opcode byte (the same characters as the
+ * text interpreter's commands, e.g. 'i' or 'l') followed by an 8-byte key in
+ * the machine's native byte order. commands without an argument (e.g. 'p',
+ * 's', 'q') still take up a whole record, and their key is ignored
+ *
+ * a file whose size isn't a multiple of the record size ends in a truncated
+ * record: 'a2 -b' warns about the leftover bytes, ignores them, and runs
+ * every whole record before them
+ *
+ * created for COMP20007 Design of Algorithms - Assignment 2, 2017
+ * by Max Philip
+ */
+
+#ifndef BINARY_H
+#define BINARY_H
+
+#include "inthash.h"
+
+// size of a single command record in bytes: opcode + key
+#define BINARY_RECORD_SIZE (1 + sizeof (int64))
+
+// offsets of the opcode and the key within a record
+#define BINARY_OP_OFFSET  0
+#define BINARY_KEY_OFFSET 1
+
+#endif
@@ -4,30 +4,46 @@
  * 
  * usage:
  *   make cmdgen
- *   ./cmdgen ninserts nlookups > commandfilename
+ *   ./cmdgen ninserts nlookups [-b] [-z bits] > commandfilename
  *       ninserts: number of insert commands to generate
  *       nlookups: number of lookup commands to generate
+ *       -b: write packed binary records (see binary.h) instead of text,
+ *           for running with 'a2 -b commandfilename'
+ *       -z bits: skew the inserted keys: every second one has a hash value
+ *           (h1) ending in 'bits' zero bits, so that they crowd into one
+ *           corner of an extendible table's hash space
  *       commandfilename: name of file to store commands in
  *
  * created for COMP20007 Design of Algorithms - Assignment 2, 2017
  * by Shreyash Patodia and Matt Farrugia
  * 
- * modifications by ...
+ * modifications by Max Philip
  */
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
 #include <time.h>
 
 #include "inthash.h"
+#include "binary.h"
+
+/* Most hash value bits a skewed key can be made to end in (it takes about
+ * 2^bits tries to find each one). */
+#define MAX_SKEW_BITS 16
 
 /*************************************************************************/
 
 void printusageexit(char *exe) {
 	/* Print usage information: */
-	fprintf(stderr, "usage: %s ninserts nlookups > commandfilename\n", exe);
+	fprintf(stderr, "usage: %s ninserts nlookups [-b] [-z bits]"
+		" > commandfilename\n", exe);
 	fprintf(stderr, " ninserts: number of insert commands to generate\n");
 	fprintf(stderr, " nlookups: number of lookup commands to generate\n");
+	fprintf(stderr, " -b: write packed binary commands instead of text\n");
+	fprintf(stderr, " -z bits: make every second insert a key whose hash"
+		" ends in 'bits' zero bits, 0 <= bits <= %d\n", MAX_SKEW_BITS);
 	fprintf(stderr, " commandfilename: name of file to store commands in\n");
 
 	/* and exit, as promised :) */
@@ -36,6 +52,41 @@ void printusageexit(char *exe) {
 
 /*************************************************************************/
 
+/* Whether to write packed binary records rather than text commands. */
+bool binary = false;
+
+/* Generate a random key below 'max' whose hash value h1 ends in 'bits' zero
+ * bits, by trying random keys until one does. There are only about
+ * max / 2^bits such keys, so the keys are drawn from a range 2^bits times
+ * as large. */
+int64 skewed_key(int max, int bits) {
+	int64 range = (int64)max << bits;
+	while (true) {
+		int64 key = (((int64)rand() << 31) ^ rand()) % range;
+		if ((h1(key) & ((1 << bits) - 1)) == 0) {
+			return key;
+		}
+	}
+}
+
+/* Write a single command with operation 'op' and argument 'key' to stdout,
+ * either as a text line or as a binary record. Text commands without an
+ * argument are written without one. */
+void emit(char op, int64 key, bool haskey) {
+	if (binary) {
+		unsigned char record[BINARY_RECORD_SIZE];
+		record[BINARY_OP_OFFSET] = op;
+		memcpy(record + BINARY_KEY_OFFSET, &key, sizeof key);
+		fwrite(record, BINARY_RECORD_SIZE, 1, stdout);
+	} else if (haskey) {
+		printf("%c %llu\n", op, key);
+	} else {
+		printf("%c\n", op);
+	}
+}
+
+/*************************************************************************/
+
 int main(int argc, char **argv) {
 	int i;
 
@@ -45,6 +96,19 @@ int main(int argc, char **argv) {
 	}
 	int ninserts  = atoi(argv[1]);
 	int nlookups = atoi(argv[2]);
+	int skew_bits = -1;
+	for (i = 3; i < argc; i++) {
+		if (strcmp(argv[i], "-b") == 0) {
+			binary = true;
+		} else if (strcmp(argv[i], "-z") == 0 && i + 1 < argc) {
+			skew_bits = atoi(argv[++i]);
+			if (skew_bits < 0 || skew_bits > MAX_SKEW_BITS) {
+				printusageexit(argv[0]);
+			}
+		} else {
+			printusageexit(argv[0]);
+		}
+	}
 
 	/* Seed the random number generator. */
 	srand(time(NULL));
@@ -53,12 +117,16 @@ int main(int argc, char **argv) {
 	int max = 100 * ninserts + 1;
 	int64 *inserts = malloc(sizeof (int64) * ninserts);
 	for (i = 0; i < ninserts; i++) {
-		inserts[i] = rand() % max;
+		if (skew_bits >= 0 && i % 2 == 0) {
+			inserts[i] = skewed_key(max, skew_bits);
+		} else {
+			inserts[i] = rand() % max;
+		}
 	}
 
 	/* Print insertion commands for these numbers. */
 	for (i = 0; i < ninserts; i++) {
-		printf("i %llu\n", inserts[i]);
+		emit('i', inserts[i], true);
 	}
 
 
@@ -75,14 +143,14 @@ int main(int argc, char **argv) {
 			/* Generate a new random key */
 			lookup = rand() % max;
 		}
-		printf("l %llu\n", lookup);
+		emit('l', lookup, true);
 	}
 
 	/* Finish with commands to print the table, print statistics, and quit. */
 
-	printf("p\n");
-	printf("s\n");
-	printf("q\n"); 
+	emit('p', 0, false);
+	emit('s', 0, false);
+	emit('q', 0, false);
 
 	return 0;
 }
@@ -0,0 +1,181 @@
+/* * * * * * * * *
+ * Module for the directory of an extendible hash table: an array of 2^depth
+ * bucket pointers that doubles and halves as the table grows and shrinks
+ *
+ * created for COMP20007 Design of Algorithms - Assignment 2, 2017
+ * by Max Philip
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+
+#include "directory.h"
+#include "inthash.h"
+
+// number of segments a lazy directory of depth 'depth' spans
+#define segments_for(depth) \
+	((depth) > SEGMENT_BITS ? 1 << ((depth) - SEGMENT_BITS) : 1)
+
+// initialise 'dir' with depth 0 (a single entry), lazy if 'lazy' is set
+void dir_init(Directory *dir, bool lazy) {
+	assert(dir);
+	dir->depth = 0;
+	dir->lazy = lazy;
+	dir->entries = NULL;
+	dir->segments = NULL;
+	dir->nsegments = 0;
+	dir->nallocated = 0;
+
+	if (lazy) {
+		dir->nsegments = 1;
+		dir->segments = malloc(sizeof *dir->segments);
+		assert(dir->segments);
+		dir->segments[0] = NULL;
+	} else {
+		dir->entries = malloc(sizeof *dir->entries);
+		assert(dir->entries);
+		dir->entries[0] = NULL;
+	}
+}
+
+// free the memory used by the entries of 'dir'
+void dir_free(Directory *dir) {
+	assert(dir);
+	if (dir->lazy) {
+		int i;
+		for (i = 0; i < dir->nsegments; i++) {
+			free(dir->segments[i]);
+		}
+		free(dir->segments);
+	} else {
+		free(dir->entries);
+	}
+}
+
+// find the entry at 'address' of a lazy directory, following unwritten
+// entries back to the entries they stand in for
+void *dir_lookup(Directory *dir, int address) {
+	while (true) {
+		void **segment = dir->segments[address >> SEGMENT_BITS];
+		if (segment && segment[address & SEGMENT_MASK]) {
+			return segment[address & SEGMENT_MASK];
+		}
+		// entry 0 is always written, so this ends there at the latest
+		assert(address > 0);
+		address &= ~(1 << (31 - __builtin_clz(address)));
+	}
+}
+
+// set the entry at 'address' of 'dir' to 'entry'
+void dir_set(Directory *dir, int address, void *entry) {
+	if (!dir->lazy) {
+		dir->entries[address] = entry;
+		return;
+	}
+
+	// a segment is only allocated (all unwritten) once it's written to
+	void ***segment = &dir->segments[address >> SEGMENT_BITS];
+	if (*segment == NULL) {
+		*segment = calloc(SEGMENT_SIZE, sizeof **segment);
+		assert(*segment);
+		dir->nallocated++;
+	}
+	(*segment)[address & SEGMENT_MASK] = entry;
+}
+
+// grow 'dir' to 2^'depth' entries, each new entry a copy of the entry at the
+// same address without its top bits
+void dir_grow(Directory *dir, int depth) {
+	assert(depth >= dir->depth);
+	assert((1 << depth) < MAX_TABLE_SIZE && "error: table has grown too large!");
+	int oldsize = 1 << dir->depth, size = 1 << depth;
+
+	if (dir->lazy) {
+		// just make room for the new (unallocated) segments: their entries
+		// read as the entries they would have been copied from
+		int nsegments = segments_for(depth);
+		dir->segments = realloc(dir->segments,
+			(sizeof *dir->segments) * nsegments);
+		assert(dir->segments);
+		int i;
+		for (i = dir->nsegments; i < nsegments; i++) {
+			dir->segments[i] = NULL;
+		}
+		dir->nsegments = nsegments;
+	} else {
+		// get a bigger array of entries, and copy the old entries up
+		dir->entries = realloc(dir->entries, (sizeof *dir->entries) * size);
+		assert(dir->entries);
+		int i;
+		for (i = oldsize; i < size; i++) {
+			dir->entries[i] = dir->entries[i & (oldsize - 1)];
+		}
+	}
+	dir->depth = depth;
+}
+
+// shrink 'dir' to 2^'depth' entries, dropping the entries past the end
+void dir_shrink(Directory *dir, int depth) {
+	assert(depth <= dir->depth);
+	if (dir->lazy) {
+		int nsegments = segments_for(depth);
+		int i;
+		for (i = nsegments; i < dir->nsegments; i++) {
+			if (dir->segments[i]) {
+				free(dir->segments[i]);
+				dir->nallocated--;
+			}
+		}
+		dir->nsegments = nsegments;
+		dir->segments = realloc(dir->segments,
+			(sizeof *dir->segments) * nsegments);
+		assert(dir->segments);
+
+		// a directory smaller than a segment leaves entries behind in its
+		// first segment: forget them, or they'd hide the entries they should
+		// stand in for if the directory grows again
+		if (depth < SEGMENT_BITS && dir->segments[0]) {
+			int end = dir->depth < SEGMENT_BITS ? 1 << dir->depth : SEGMENT_SIZE;
+			int i;
+			for (i = 1 << depth; i < end; i++) {
+				dir->segments[0][i] = NULL;
+			}
+		}
+	} else {
+		dir->entries = realloc(dir->entries,
+			(sizeof *dir->entries) * (1 << depth));
+		assert(dir->entries);
+	}
+	dir->depth = depth;
+}
+
+// rewrite the entry that 'address' of 'dir' reads as 'entry' (for an
+// unwritten entry of a lazy directory, that's the written entry it stands in
+// for, which points to the same bucket: it is rewritten instead, and the
+// unwritten entry stays unallocated)
+void dir_retag(Directory *dir, int address, void *entry) {
+	if (!dir->lazy) {
+		dir->entries[address] = entry;
+		return;
+	}
+
+	// follow unwritten entries back as in dir_lookup
+	while (true) {
+		void **segment = dir->segments[address >> SEGMENT_BITS];
+		if (segment && segment[address & SEGMENT_MASK]) {
+			segment[address & SEGMENT_MASK] = entry;
+			return;
+		}
+		assert(address > 0);
+		address &= ~(1 << (31 - __builtin_clz(address)));
+	}
+}
+
+// bytes of memory used by the entries of 'dir'
+size_t dir_bytes(Directory *dir) {
+	if (dir->lazy) {
+		return (sizeof *dir->segments) * dir->nsegments
+			+ (sizeof **dir->segments) * SEGMENT_SIZE * dir->nallocated;
+	}
+	return (sizeof *dir->entries) << dir->depth;
+}
@@ -0,0 +1,161 @@
+/* * * * * * * * *
+ * Module for the directory of an extendible hash table: an array of 2^depth
+ * bucket pointers that doubles and halves as the table grows and shrinks
+ *
+ * an eager directory is a single array, so doubling it copies every entry.
+ * a lazy directory is split into segments, and doubling it only makes room
+ * for more segments: an entry that hasn't been written since the directory
+ * doubled reads as the entry it would have been copied from (the same
+ * address without its top bit), so nothing needs copying
+ *
+ * an entry can also carry a little information about the bucket it points
+ * to, so that a lookup can often finish without following the pointer at
+ * all: the lowest bit of the (8-byte aligned) pointer flags a bucket holding
+ * a key, and on 64-bit platforms the top ENTRY_FINGERPRINT_BITS bits, which
+ * user-space addresses normally don't use, hold a fingerprint of that key.
+ * a pointer that does use those bits (with 5-level paging, or hardware that
+ * tags pointers) is checked for when the entry is made, and is stored
+ * untagged instead: its entry tells a lookup nothing, and the lookup has to
+ * check the bucket
+ *
+ * created for COMP20007 Design of Algorithms - Assignment 2, 2017
+ * by Max Philip
+ */
+
+#ifndef DIRECTORY_H
+#define DIRECTORY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include "batch.h"
+#include "inthash.h"
+
+// a lazy directory is made of segments of 2^SEGMENT_BITS entries each
+#define SEGMENT_BITS 12
+#define SEGMENT_SIZE (1 << SEGMENT_BITS)
+#define SEGMENT_MASK (SEGMENT_SIZE - 1)
+
+typedef struct directory {
+	int depth;			// the directory has 2^depth entries
+	bool lazy;			// grow lazily (segments) rather than eagerly (array)
+	void **entries;		// eager: all of the entries
+	void ***segments;	// lazy: the segments of entries, or NULL for a segment
+						// with no entries written since the directory grew
+	int nsegments;		// lazy: how many segments the directory spans
+	int nallocated;		// lazy: how many segments have been allocated
+} Directory;
+
+// initialise 'dir' with depth 0 (a single entry), lazy if 'lazy' is set
+void dir_init(Directory *dir, bool lazy);
+
+// free the memory used by the entries of 'dir'
+void dir_free(Directory *dir);
+
+// find the entry at 'address' of a lazy directory, following unwritten
+// entries back to the entries they stand in for
+void *dir_lookup(Directory *dir, int address);
+
+// the entry at 'address' of 'dir'
+static inline void *dir_get(Directory *dir, int address) {
+	return dir->lazy ? dir_lookup(dir, address) : dir->entries[address];
+}
+
+// hint that the entry at 'address' of 'dir' will be read soon
+static inline void dir_prefetch(Directory *dir, int address) {
+	if (!dir->lazy) {
+		prefetch(&dir->entries[address]);
+	} else if (dir->segments[address >> SEGMENT_BITS]) {
+		prefetch(&dir->segments[address >> SEGMENT_BITS][address & SEGMENT_MASK]);
+	}
+}
+
+// set the entry at 'address' of 'dir' to 'entry'
+void dir_set(Directory *dir, int address, void *entry);
+
+// grow 'dir' to 2^'depth' entries, each new entry a copy of the entry at the
+// same address without its top bits
+void dir_grow(Directory *dir, int depth);
+
+// shrink 'dir' to 2^'depth' entries, dropping the entries past the end
+void dir_shrink(Directory *dir, int depth);
+
+// rewrite the entry that 'address' of 'dir' reads as 'entry' (for an
+// unwritten entry of a lazy directory, that's the written entry it stands in
+// for, which points to the same bucket: it is rewritten instead, and the
+// unwritten entry stays unallocated)
+void dir_retag(Directory *dir, int address, void *entry);
+
+// bytes of memory used by the entries of 'dir'
+size_t dir_bytes(Directory *dir);
+
+
+/* * * *
+ * tagged entries
+ */
+
+#if UINTPTR_MAX > 0xffffffffu
+#define ENTRY_FINGERPRINT_BITS 16
+#else
+#define ENTRY_FINGERPRINT_BITS 0
+#endif
+
+// the bit flagging a full bucket, the bit flagging an untagged entry (which
+// may point to a bucket holding any key), and the bits of a tagged entry
+// holding the pointer
+#define ENTRY_FULL ((uintptr_t)1)
+#define ENTRY_UNTAGGED ((uintptr_t)2)
+#define ENTRY_FLAGS (ENTRY_FULL | ENTRY_UNTAGGED)
+#define ENTRY_POINTER_MASK \
+	((~(uintptr_t)0 >> ENTRY_FINGERPRINT_BITS) & ~ENTRY_FLAGS)
+
+// the fingerprint of 'key', in the position it takes in an entry (taken from
+// the top bits of a multiplicative hash, so it doesn't depend on the bits of
+// h1 or h2 that chose the entry)
+#if ENTRY_FINGERPRINT_BITS
+#define entry_fingerprint(key) ((uintptr_t)(((uint64_t)(key) \
+	* 0x9e3779b97f4a7c15ull) >> (64 - ENTRY_FINGERPRINT_BITS)) \
+	<< (sizeof (uintptr_t) * 8 - ENTRY_FINGERPRINT_BITS))
+#else
+#define entry_fingerprint(key) ((uintptr_t)0)
+#endif
+
+// an untagged entry pointing to 'pointer', for a bucket that might hold any
+// key (or several keys)
+static inline void *dir_untagged_entry(void *pointer) {
+	assert(((uintptr_t)pointer & ENTRY_FLAGS) == 0
+		&& "error: bucket pointer isn't aligned!");
+	return (void *)((uintptr_t)pointer | ENTRY_UNTAGGED);
+}
+
+// an entry pointing to 'pointer', flagged as full with a fingerprint of 'key'
+// if 'full' is set (or untagged, if the pointer uses the fingerprint's bits)
+static inline void *dir_entry(void *pointer, bool full, int64 key) {
+	if ((uintptr_t)pointer & ~(ENTRY_POINTER_MASK | ENTRY_FLAGS)) {
+		return dir_untagged_entry(pointer);
+	}
+	assert(((uintptr_t)pointer & ENTRY_FLAGS) == 0
+		&& "error: bucket pointer isn't aligned!");
+	return (void *)((uintptr_t)pointer
+		| (full ? ENTRY_FULL | entry_fingerprint(key) : 0));
+}
+
+// the pointer in 'entry', without its tag
+static inline void *entry_pointer(void *entry) {
+	uintptr_t bits = (uintptr_t)entry;
+	return (void *)(bits
+		& (bits & ENTRY_UNTAGGED ? ~ENTRY_FLAGS : ENTRY_POINTER_MASK));
+}
+
+// could 'entry' point to a bucket holding 'key'? (false means it definitely
+// doesn't, true means the bucket is full with a key of the same fingerprint,
+// or the entry is untagged: either way, only the bucket can say for sure)
+static inline bool entry_may_hold(void *entry, int64 key) {
+	uintptr_t bits = (uintptr_t)entry;
+	uintptr_t tag = ENTRY_FULL | entry_fingerprint(key);
+	return (bits & ENTRY_UNTAGGED) || (bits & ~ENTRY_POINTER_MASK) == tag;
+}
+
+#endif
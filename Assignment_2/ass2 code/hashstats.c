@@ -0,0 +1,45 @@
+/* * * * * * * * *
+ * Module for machine-readable statistics about a hash table, filled in the
+ * same way by every type of table (see hash_table_get_stats in hashtbl.h),
+ * and for printing them as JSON
+ *
+ * created for COMP20007 Design of Algorithms - Assignment 2, 2017
+ * by Max Philip
+ */
+
+#include <assert.h>
+
+#include "hashstats.h"
+
+// set every counter in 'stats' to 0 (and its type to NULL)
+void init_hash_stats(HashStats *stats) {
+	assert(stats);
+	stats->type = NULL;
+	stats->load = 0;
+	stats->capacity = 0;
+	stats->memory = 0;
+	stats->probes = 0;
+	stats->evictions = 0;
+	stats->splits = 0;
+	stats->resizes = 0;
+	stats->resize_time = 0;
+	stats->rejected = 0;
+}
+
+// print 'stats' to 'stream' as a single-line JSON object, along with the
+// load factor they imply
+void print_hash_stats_json(FILE *stream, HashStats *stats) {
+	assert(stats);
+
+	// table type names are plain identifiers, so need no escaping
+	fprintf(stream, "{\"type\": \"%s\", ", stats->type ? stats->type : "");
+	fprintf(stream, "\"load\": %ld, \"capacity\": %ld, \"load_factor\": %.6f, ",
+		stats->load, stats->capacity,
+		stats->capacity ? stats->load * 1.0 / stats->capacity : 0);
+	fprintf(stream, "\"memory_bytes\": %ld, ", stats->memory);
+	fprintf(stream, "\"probes\": %ld, \"evictions\": %ld, \"splits\": %ld, ",
+		stats->probes, stats->evictions, stats->splits);
+	fprintf(stream, "\"resizes\": %ld, \"resize_seconds\": %.6f, ",
+		stats->resizes, stats->resize_time);
+	fprintf(stream, "\"rejected\": %ld}\n", stats->rejected);
+}
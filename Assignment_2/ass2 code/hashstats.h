@@ -0,0 +1,45 @@
+/* * * * * * * * *
+ * Module for machine-readable statistics about a hash table, filled in the
+ * same way by every type of table (see hash_table_get_stats in hashtbl.h),
+ * and for printing them as JSON
+ *
+ * created for COMP20007 Design of Algorithms - Assignment 2, 2017
+ * by Max Philip
+ */
+
+#ifndef HASHSTATS_H
+#define HASHSTATS_H
+
+#include <stdio.h>
+
+// statistics about a hash table. a counter that a type of table has no use
+// for (such as evictions, for a table that never moves keys) stays at 0
+typedef struct hash_stats {
+	const char *type;	// the type of table, as for strtotype ("linear", ...)
+	long load;			// number of keys in the table (including any stash)
+	long capacity;		// number of keys the table's slots or buckets can
+						// hold right now (not counting any stash)
+	long memory;		// bytes held by the table's slots, buckets,
+						// directories and stash
+	long probes;		// slots past their home that insertions have stepped
+						// over (linear), or groups that searches have
+						// examined (swiss)
+	long evictions;		// keys moved out of their slot to make room for
+						// another (cuckoo tables)
+	long splits;		// buckets split in two or more (extendible tables)
+	long resizes;		// times the table's arrays (or, for the extendible
+						// tables, a directory) have been resized
+	double resize_time;	// CPU seconds spent resizing
+	long rejected;		// insertions refused because the key's bucket could
+						// neither split nor chain another overflow bucket
+						// (extendible tables)
+} HashStats;
+
+// set every counter in 'stats' to 0 (and its type to NULL)
+void init_hash_stats(HashStats *stats);
+
+// print 'stats' to 'stream' as a single-line JSON object, along with the
+// load factor they imply
+void print_hash_stats_json(FILE *stream, HashStats *stats);
+
+#endif
@@ -6,6 +6,7 @@
  * by Matt Farrugia <matt.farrugia@unimelb.edu.au>
  */
 
+#include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <assert.h>
@@ -17,6 +18,17 @@
 #include "tables/cuckoo.h"	// create for part 1
 #include "tables/xtndbln.h" // create for part 2
 #include "tables/xuckoo.h"	// create for part 3
+#include "tables/swiss.h"
+#include "tables/xtndblt.h"
+#include "tables/xuckoon.h"
+#include "tables/cuckoo3.h"
+
+// the name of each type of table, indexed by its TableType constant (as
+// accepted by strtotype)
+static const char *type_names[] = {
+	"linear", "xtndbl1", "cuckoo", "xtndbln", "xuckoo", "swiss", "xtndblt",
+	"xuckoon", "cuckoo3"
+};
 
 // converts from a string representation to a TableType constant:
 // "linear"			->	LINEAR
@@ -24,6 +36,10 @@
 // "1" or "cuckoo"	->	CUCKOO
 // "2" or "xtndbln"	->	XTNDBLN
 // "3" or "xuckoo"	->	XUCKOO
+// "swiss"			->	SWISS
+// "xtndblt"		->	XTNDBLT
+// "xuckoon"		->	XUCKOON
+// "cuckoo3"		->	CUCKOO3
 TableType strtotype(char *str) {
 	if (strcmp("linear",  str) == 0) {
 		return LINEAR;
@@ -40,6 +56,18 @@ TableType strtotype(char *str) {
 	if (strcmp("3", str) == 0 || strcmp("xuckoo",  str) == 0) {
 		return XUCKOO;
 	}
+	if (strcmp("swiss",   str) == 0) {
+		return SWISS;
+	}
+	if (strcmp("xtndblt", str) == 0) {
+		return XTNDBLT;
+	}
+	if (strcmp("xuckoon", str) == 0) {
+		return XUCKOON;
+	}
+	if (strcmp("cuckoo3", str) == 0) {
+		return CUCKOO3;
+	}
 	return NOTYPE;
 }
 
@@ -50,10 +78,18 @@ struct table {
 	void *table;	// the hash table itself
 };
 
-// initialise a hash table of type 'type' with initial size 'size',
+// initialise a hash table of type 'type' with initial size 'size', tuned by
+// 'options' (or the default options, if 'options' is NULL),
 // and return its pointer
-HashTable *new_hash_table(TableType type, int size) {
-	
+HashTable *new_hash_table(TableType type, int size, TableOptions *options) {
+
+	// fall back to the default options
+	TableOptions defaults;
+	if (options == NULL) {
+		default_table_options(&defaults);
+		options = &defaults;
+	}
+
 	// allocate space for the table wrapper
 	HashTable *table = malloc(sizeof *table);
 	assert(table);
@@ -64,19 +100,31 @@ HashTable *new_hash_table(TableType type, int size) {
 	// create and store the table itself
 	switch (type) {
 		case LINEAR:
-			table->table = new_linear_hash_table(size);
+			table->table = new_linear_hash_table(size, options);
 			break;
 		case XTNDBL1:
-			table->table = new_xtndbl1_hash_table();
+			table->table = new_xtndbl1_hash_table(options);
 			break;
 		case CUCKOO:
-			table->table = new_cuckoo_hash_table(size);
+			table->table = new_cuckoo_hash_table(size, options);
 			break;
 		case XTNDBLN:
-			table->table = new_xtndbln_hash_table(size);
+			table->table = new_xtndbln_hash_table(size, options);
 			break;
 		case XUCKOO:
-			table->table = new_xuckoo_hash_table();
+			table->table = new_xuckoo_hash_table(options);
+			break;
+		case SWISS:
+			table->table = new_swiss_hash_table(size, options);
+			break;
+		case XTNDBLT:
+			table->table = new_xtndblt_hash_table(size, options);
+			break;
+		case XUCKOON:
+			table->table = new_xuckoon_hash_table(size, options);
+			break;
+		case CUCKOO3:
+			table->table = new_cuckoo3_hash_table(size, options);
 			break;
 		default:
 			// no such table type? error. release memory and return NULL
@@ -108,6 +156,18 @@ void free_hash_table(HashTable *table) {
 		case XUCKOO:
 			free_xuckoo_hash_table(table->table);
 			break;
+		case SWISS:
+			free_swiss_hash_table(table->table);
+			break;
+		case XTNDBLT:
+			free_xtndblt_hash_table(table->table);
+			break;
+		case XUCKOON:
+			free_xuckoon_hash_table(table->table);
+			break;
+		case CUCKOO3:
+			free_cuckoo3_hash_table(table->table);
+			break;
 		default:
 			break;
 	}
@@ -117,7 +177,8 @@ void free_hash_table(HashTable *table) {
 }
 
 // insert 'key' into 'table', if it's not in there already
-// returns true if insertion succeeds, false if it was already in there
+// returns true if insertion succeeds, false if it was already in there (or
+// there was no room for it)
 bool hash_table_insert(HashTable *table, int64 key) {
 	assert(table != NULL);
 
@@ -133,7 +194,80 @@ bool hash_table_insert(HashTable *table, int64 key) {
 			return xtndbln_hash_table_insert(table->table, key);
 		case XUCKOO:
 			return xuckoo_hash_table_insert(table->table, key);
+		case SWISS:
+			return swiss_hash_table_insert(table->table, key);
+		case XTNDBLT:
+			return xtndblt_hash_table_insert(table->table, key);
+		case XUCKOON:
+			return xuckoon_hash_table_insert(table->table, key);
+		case CUCKOO3:
+			return cuckoo3_hash_table_insert(table->table, key);
+		default:
+			return false;
+	}
+}
+
+// insert 'key' into 'table', if it's not in there already
+// returns INSERTED, DUPLICATE or REJECTED
+InsertStatus hash_table_insert_status(HashTable *table, int64 key) {
+	if (hash_table_insert(table, key)) {
+		return INSERTED;
+	}
+
+	// a refused insertion leaves the table without the key, whereas a
+	// duplicate was in there all along, so one lookup tells the two apart
+	return hash_table_lookup(table, key) ? DUPLICATE : REJECTED;
+}
+
+// insert the 'n' keys in 'keys' into 'table', in order, setting bit i of the
+// bitmap 'results' if keys[i] was inserted, clearing it if already there (or
+// rejected)
+// returns the number of keys inserted
+int hash_table_insert_batch(HashTable *table, int64 *keys, int n,
+	uint8_t *results) {
+	assert(table != NULL);
+
+	// forward the call onto the relevant batch insert function
+	switch (table->type) {
+		case LINEAR:
+			return linear_hash_table_insert_batch(table->table, keys, n, results);
+		case XTNDBL1:
+			return xtndbl1_hash_table_insert_batch(table->table, keys, n, results);
+		case CUCKOO:
+			return cuckoo_hash_table_insert_batch(table->table, keys, n, results);
+		case XTNDBLN:
+			return xtndbln_hash_table_insert_batch(table->table, keys, n, results);
+		case XUCKOO:
+			return xuckoo_hash_table_insert_batch(table->table, keys, n, results);
+		case SWISS:
+			return swiss_hash_table_insert_batch(table->table, keys, n, results);
+		case XTNDBLT:
+			return xtndblt_hash_table_insert_batch(table->table, keys, n, results);
+		case XUCKOON:
+			return xuckoon_hash_table_insert_batch(table->table, keys, n, results);
+		case CUCKOO3:
+			return cuckoo3_hash_table_insert_batch(table->table, keys, n, results);
+		default:
+			return 0;
+	}
+}
+
+// delete 'key' from 'table', if it's in there
+// returns true if deletion succeeds, false if it wasn't in there
+bool hash_table_delete(HashTable *table, int64 key) {
+	assert(table != NULL);
+
+	// forward the call onto the relevant delete function
+	switch (table->type) {
+		case XTNDBL1:
+			return xtndbl1_hash_table_delete(table->table, key);
+		case XTNDBLN:
+			return xtndbln_hash_table_delete(table->table, key);
+		case XUCKOO:
+			return xuckoo_hash_table_delete(table->table, key);
 		default:
+			fprintf(stderr, "error: this type of table doesn't support"
+				" deletion\n");
 			return false;
 	}
 }
@@ -155,11 +289,71 @@ bool hash_table_lookup(HashTable *table, int64 key) {
 			return xtndbln_hash_table_lookup(table->table, key);
 		case XUCKOO:
 			return xuckoo_hash_table_lookup(table->table, key);
+		case SWISS:
+			return swiss_hash_table_lookup(table->table, key);
+		case XTNDBLT:
+			return xtndblt_hash_table_lookup(table->table, key);
+		case XUCKOON:
+			return xuckoon_hash_table_lookup(table->table, key);
+		case CUCKOO3:
+			return cuckoo3_hash_table_lookup(table->table, key);
 		default:
 			return false;
 	}
 }
 
+// lookup each of the 'n' keys in 'keys', setting bit i of the bitmap
+// 'results' if keys[i] is inside 'table', clearing it if not
+// returns the number of keys found
+int hash_table_lookup_batch(HashTable *table, int64 *keys, int n,
+	uint8_t *results) {
+	assert(table != NULL);
+
+	// forward the call onto the relevant batch lookup function
+	switch (table->type) {
+		case LINEAR:
+			return linear_hash_table_lookup_batch(table->table, keys, n, results);
+		case XTNDBL1:
+			return xtndbl1_hash_table_lookup_batch(table->table, keys, n, results);
+		case CUCKOO:
+			return cuckoo_hash_table_lookup_batch(table->table, keys, n, results);
+		case XTNDBLN:
+			return xtndbln_hash_table_lookup_batch(table->table, keys, n, results);
+		case XUCKOO:
+			return xuckoo_hash_table_lookup_batch(table->table, keys, n, results);
+		case SWISS:
+			return swiss_hash_table_lookup_batch(table->table, keys, n, results);
+		case XTNDBLT:
+			return xtndblt_hash_table_lookup_batch(table->table, keys, n, results);
+		case XUCKOON:
+			return xuckoon_hash_table_lookup_batch(table->table, keys, n, results);
+		case CUCKOO3:
+			return cuckoo3_hash_table_lookup_batch(table->table, keys, n, results);
+		default:
+			return 0;
+	}
+}
+
+// the number of keys 'table' has slots for before it next grows, or 0 for
+// the extendible tables
+int hash_table_capacity(HashTable *table) {
+	assert(table != NULL);
+
+	// forward the call onto the relevant capacity function
+	switch (table->type) {
+		case LINEAR:
+			return linear_hash_table_capacity(table->table);
+		case CUCKOO:
+			return cuckoo_hash_table_capacity(table->table);
+		case SWISS:
+			return swiss_hash_table_capacity(table->table);
+		case CUCKOO3:
+			return cuckoo3_hash_table_capacity(table->table);
+		default:
+			return 0;
+	}
+}
+
 // print the contents of 'table' to stdout
 void hash_table_print(HashTable *table) {
 	assert(table != NULL);
@@ -181,6 +375,18 @@ void hash_table_print(HashTable *table) {
 		case XUCKOO:
 			xuckoo_hash_table_print(table->table);
 			break;
+		case SWISS:
+			swiss_hash_table_print(table->table);
+			break;
+		case XTNDBLT:
+			xtndblt_hash_table_print(table->table);
+			break;
+		case XUCKOON:
+			xuckoon_hash_table_print(table->table);
+			break;
+		case CUCKOO3:
+			cuckoo3_hash_table_print(table->table);
+			break;
 		default:
 			break;
 	}
@@ -207,7 +413,59 @@ void hash_table_stats(HashTable *table) {
 		case XUCKOO:
 			xuckoo_hash_table_stats(table->table);
 			break;
+		case SWISS:
+			swiss_hash_table_stats(table->table);
+			break;
+		case XTNDBLT:
+			xtndblt_hash_table_stats(table->table);
+			break;
+		case XUCKOON:
+			xuckoon_hash_table_stats(table->table);
+			break;
+		case CUCKOO3:
+			cuckoo3_hash_table_stats(table->table);
+			break;
 		default:
 			break;
 	}
-}
\ No newline at end of file
+}
+
+// fill 'stats' with statistics about 'table'
+void hash_table_get_stats(HashTable *table, HashStats *stats) {
+	assert(table != NULL);
+
+	// call the relevant get stats function
+	switch (table->type) {
+		case LINEAR:
+			linear_hash_table_get_stats(table->table, stats);
+			break;
+		case XTNDBL1:
+			xtndbl1_hash_table_get_stats(table->table, stats);
+			break;
+		case CUCKOO:
+			cuckoo_hash_table_get_stats(table->table, stats);
+			break;
+		case XTNDBLN:
+			xtndbln_hash_table_get_stats(table->table, stats);
+			break;
+		case XUCKOO:
+			xuckoo_hash_table_get_stats(table->table, stats);
+			break;
+		case SWISS:
+			swiss_hash_table_get_stats(table->table, stats);
+			break;
+		case XTNDBLT:
+			xtndblt_hash_table_get_stats(table->table, stats);
+			break;
+		case XUCKOON:
+			xuckoon_hash_table_get_stats(table->table, stats);
+			break;
+		case CUCKOO3:
+			cuckoo3_hash_table_get_stats(table->table, stats);
+			break;
+		default:
+			init_hash_stats(stats);
+			return;
+	}
+	stats->type = type_names[table->type];
+}
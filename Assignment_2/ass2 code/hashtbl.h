@@ -11,11 +11,15 @@
 
 #include <stdbool.h>
 #include "inthash.h"
+#include "batch.h"
+#include "options.h"
+#include "hashstats.h"
 
 // enumerated type containing constants for the various types of hash table
 // supported
 typedef enum type {
-	NOTYPE = -1, LINEAR, XTNDBL1, CUCKOO, XTNDBLN, XUCKOO
+	NOTYPE = -1, LINEAR, XTNDBL1, CUCKOO, XTNDBLN, XUCKOO, SWISS, XTNDBLT, XUCKOON,
+	CUCKOO3
 } TableType;
 
 // converts from a string representation to a TableType constant:
@@ -24,29 +28,76 @@ typedef enum type {
 // "1" or "cuckoo"	->	CUCKOO
 // "2" or "xtndbln"	->	XTNDBLN
 // "3" or "xuckoo"	->	XUCKOO
+// "swiss"			->	SWISS
+// "xtndblt"		->	XTNDBLT
+// "xuckoon"		->	XUCKOON
+// "cuckoo3"		->	CUCKOO3
 TableType strtotype(char *str);
 
 typedef struct table HashTable;
 
-// initialise a hash table of type 'type' with initial size 'size',
+// initialise a hash table of type 'type' with initial size 'size', tuned by
+// 'options' (or the default options, if 'options' is NULL),
 // and return its pointer
-HashTable *new_hash_table(TableType type, int size);
+HashTable *new_hash_table(TableType type, int size, TableOptions *options);
 
 // free all memory associated with 'table'
 void free_hash_table(HashTable *table);
 
+// the outcome of an insertion: the key went in, it was already in there, or
+// (for an extendible table) there was no room for it: see options.h
+typedef enum insert_status {
+	INSERTED,
+	DUPLICATE,
+	REJECTED
+} InsertStatus;
+
 // insert 'key' into 'table', if it's not in there already
-// returns true if insertion succeeds, false if it was already in there
+// returns true if insertion succeeds, false if it was already in there (or,
+// for an extendible table, there was no room for it: see options.h)
 bool hash_table_insert(HashTable *table, int64 key);
 
+// insert 'key' into 'table', if it's not in there already
+// returns INSERTED, DUPLICATE or REJECTED (see InsertStatus above)
+InsertStatus hash_table_insert_status(HashTable *table, int64 key);
+
+// insert the 'n' keys in 'keys' into 'table', in order, setting bit i of the
+// bitmap 'results' (at least bitmap_bytes(n) bytes, see batch.h) if keys[i]
+// was inserted, clearing it if it was already in there or was rejected (the
+// number rejected shows up in the 'rejected' count of hash_table_get_stats)
+// returns the number of keys inserted
+int hash_table_insert_batch(HashTable *table, int64 *keys, int n,
+	uint8_t *results);
+
+// delete 'key' from 'table', if it's in there (only the extendible tables,
+// xtndbl1, xtndbln and xuckoo, support deletion)
+// returns true if deletion succeeds, false if it wasn't in there
+bool hash_table_delete(HashTable *table, int64 key);
+
 // lookup whether 'key' is inside 'table'
 // returns true if found, false if not
 bool hash_table_lookup(HashTable *table, int64 key);
 
+// lookup each of the 'n' keys in 'keys', setting bit i of the bitmap 'results'
+// (at least bitmap_bytes(n) bytes, see batch.h) if keys[i] is inside 'table',
+// clearing it if not
+// returns the number of keys found
+int hash_table_lookup_batch(HashTable *table, int64 *keys, int n,
+	uint8_t *results);
+
+// the number of keys 'table' has slots for before it next grows, for the
+// tables with a fixed number of slots (linear, cuckoo, cuckoo3 and swiss),
+// or 0 for the extendible tables, which grow a bucket at a time
+int hash_table_capacity(HashTable *table);
+
 // print the contents of 'table' to stdout
 void hash_table_print(HashTable *table);
 
 // print some statistics about 'table' to stdout
 void hash_table_stats(HashTable *table);
 
+// fill 'stats' (see hashstats.h) with statistics about 'table', measured the
+// same way for every type of table so that they can be compared
+void hash_table_get_stats(HashTable *table, HashStats *stats);
+
 #endif
@@ -17,12 +17,274 @@
 #define B2 306837493
 #define p2 2147483563
 
+// constants for third hash function
+#define A3 1948243957
+#define B3 1206874931
+#define p3 2147483647
+
+#ifdef REFERENCE_HASH
+
 // first available hash function
 int h1(int64 k) {
-	return (A1 * k + B1) % p1;
+	return h1_ref(k);
 }
 
 // second available hash function
 int h2(int64 k) {
+	return h2_ref(k);
+}
+
+// third available hash function
+int h3(int64 k) {
+	return h3_ref(k);
+}
+
+#else
+
+// all three primes are just under 2^31: p = 2^31 - c for a small c
+#define c1 19
+#define c2 85
+#define c3 1
+#define LOW31 0x7fffffff
+
+// reduce 'x' modulo the prime p = 2^31 - c without dividing: since
+// 2^31 = c (mod p), x = hi * 2^31 + lo = hi * c + lo (mod p), so folding the
+// high bits down twice brings any 64-bit x below 2^31 + 2^17 < 2p, and a
+// final conditional subtraction finishes the job
+static int64 fold_mod(int64 x, int64 p, int64 c) {
+	x = (x >> 31) * c + (x & LOW31);	// < 2^33 * c + 2^31 < 2^41
+	x = (x >> 31) * c + (x & LOW31);	// < 2^10 * c + 2^31 < 2^31 + 2^17
+	return x >= p ? x - p : x;
+}
+
+// first available hash function
+int h1(int64 k) {
+	return fold_mod(A1 * k + B1, p1, c1);
+}
+
+// second available hash function
+int h2(int64 k) {
+	return fold_mod(A2 * k + B2, p2, c2);
+}
+
+// third available hash function
+int h3(int64 k) {
+	return fold_mod(A3 * k + B3, p3, c3);
+}
+
+#endif
+
+// reference version of the first hash function
+int h1_ref(int64 k) {
+	return (A1 * k + B1) % p1;
+}
+
+// reference version of the second hash function
+int h2_ref(int64 k) {
 	return (A2 * k + B2) % p2;
 }
+
+// reference version of the third hash function
+int h3_ref(int64 k) {
+	return (A3 * k + B3) % p3;
+}
+
+// the 'i'th hash function (i >= 1): h1, h2 and h3 themselves, then for i > 3
+// a combination h1 + (i - 3) * h3 of the first and third, reduced modulo p1
+// (as in double hashing, so the family costs two hashes however large it is)
+int hk(int i, int64 k) {
+	switch (i) {
+		case 1:
+			return h1(k);
+		case 2:
+			return h2(k);
+		case 3:
+			return h3(k);
+	}
+	int64 x = h1(k) + (int64)(i - 3) * h3(k);
+#ifdef REFERENCE_HASH
+	return x % p1;
+#else
+	return fold_mod(x, p1, c1);
+#endif
+}
+
+
+/* * * *
+ * multi-key hashing
+ */
+
+#ifdef REFERENCE_HASH
+
+// hash each of the 'n' keys in 'keys' with h1, storing results in 'hashes'
+void h1_multi(int64 *keys, int n, int *hashes) {
+	int i;
+	for (i = 0; i < n; i++) {
+		hashes[i] = h1(keys[i]);
+	}
+}
+
+// hash each of the 'n' keys in 'keys' with h2, storing results in 'hashes'
+void h2_multi(int64 *keys, int n, int *hashes) {
+	int i;
+	for (i = 0; i < n; i++) {
+		hashes[i] = h2(keys[i]);
+	}
+}
+
+// name of the kernel used by h1_multi and h2_multi
+const char *hash_multi_kernel() {
+	return "scalar";
+}
+
+#else
+
+// a multi-key hash kernel computes (a * k + b) mod p, for p = 2^31 - c, for
+// each of 'n' keys
+typedef void (*MultiKernel)(int64 *keys, int n, int *hashes,
+	int64 a, int64 b, int64 p, int64 c);
+
+// scalar kernel, also used for the keys left over after the vector kernels
+static void multi_scalar(int64 *keys, int n, int *hashes,
+	int64 a, int64 b, int64 p, int64 c) {
+	int i;
+	for (i = 0; i < n; i++) {
+		hashes[i] = fold_mod(a * keys[i] + b, p, c);
+	}
+}
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define SIMD_KERNELS
+#include <immintrin.h>
+
+// the vector kernels follow fold_mod lane by lane. neither AVX2 nor AVX-512F
+// has a full 64-bit multiply, so multiplications by the (32-bit) constants are
+// split into 32x32->64-bit multiplies of the low and high halves:
+//   a * x = a * lo(x) + (a * hi(x) << 32)   (mod 2^64)
+
+// AVX2 kernel: 4 keys at a time
+__attribute__((target("avx2")))
+static void multi_avx2(int64 *keys, int n, int *hashes,
+	int64 a, int64 b, int64 p, int64 c) {
+	__m256i va = _mm256_set1_epi64x(a), vb = _mm256_set1_epi64x(b);
+	__m256i vp = _mm256_set1_epi64x(p), vc = _mm256_set1_epi64x(c);
+	__m256i vpm1 = _mm256_set1_epi64x(p - 1);
+	__m256i low31 = _mm256_set1_epi64x(LOW31);
+	__m256i evens = _mm256_setr_epi32(0, 2, 4, 6, 0, 0, 0, 0);
+
+	int i;
+	for (i = 0; i + 4 <= n; i += 4) {
+		__m256i k = _mm256_loadu_si256((__m256i *)(keys + i));
+
+		// x = a * k + b
+		__m256i x = _mm256_add_epi64(_mm256_mul_epu32(k, va), _mm256_slli_epi64(
+			_mm256_mul_epu32(_mm256_srli_epi64(k, 32), va), 32));
+		x = _mm256_add_epi64(x, vb);
+
+		// first fold: hi is up to 33 bits, so multiply in two halves too
+		__m256i hi = _mm256_srli_epi64(x, 31);
+		hi = _mm256_add_epi64(_mm256_mul_epu32(hi, vc), _mm256_slli_epi64(
+			_mm256_mul_epu32(_mm256_srli_epi64(hi, 32), vc), 32));
+		x = _mm256_add_epi64(hi, _mm256_and_si256(x, low31));
+
+		// second fold: hi is now small enough for a single multiply
+		x = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(x, 31), vc),
+			_mm256_and_si256(x, low31));
+
+		// subtract p from lanes where x > p - 1
+		__m256i ge = _mm256_cmpgt_epi64(x, vpm1);
+		x = _mm256_sub_epi64(x, _mm256_and_si256(ge, vp));
+
+		// gather the low 32 bits of each lane and store them
+		x = _mm256_permutevar8x32_epi32(x, evens);
+		_mm_storeu_si128((__m128i *)(hashes + i), _mm256_castsi256_si128(x));
+	}
+
+	multi_scalar(keys + i, n - i, hashes + i, a, b, p, c);
+}
+
+// AVX-512 kernel: 8 keys at a time
+__attribute__((target("avx512f")))
+static void multi_avx512(int64 *keys, int n, int *hashes,
+	int64 a, int64 b, int64 p, int64 c) {
+	__m512i va = _mm512_set1_epi64(a), vb = _mm512_set1_epi64(b);
+	__m512i vp = _mm512_set1_epi64(p), vc = _mm512_set1_epi64(c);
+	__m512i low31 = _mm512_set1_epi64(LOW31);
+
+	int i;
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m512i k = _mm512_loadu_si512(keys + i);
+
+		// x = a * k + b
+		__m512i x = _mm512_add_epi64(_mm512_mul_epu32(k, va), _mm512_slli_epi64(
+			_mm512_mul_epu32(_mm512_srli_epi64(k, 32), va), 32));
+		x = _mm512_add_epi64(x, vb);
+
+		// first fold: hi is up to 33 bits, so multiply in two halves too
+		__m512i hi = _mm512_srli_epi64(x, 31);
+		hi = _mm512_add_epi64(_mm512_mul_epu32(hi, vc), _mm512_slli_epi64(
+			_mm512_mul_epu32(_mm512_srli_epi64(hi, 32), vc), 32));
+		x = _mm512_add_epi64(hi, _mm512_and_si512(x, low31));
+
+		// second fold: hi is now small enough for a single multiply
+		x = _mm512_add_epi64(_mm512_mul_epu32(_mm512_srli_epi64(x, 31), vc),
+			_mm512_and_si512(x, low31));
+
+		// subtract p from lanes where x >= p
+		__mmask8 ge = _mm512_cmpge_epu64_mask(x, vp);
+		x = _mm512_mask_sub_epi64(x, ge, x, vp);
+
+		// narrow each lane to 32 bits and store
+		_mm256_storeu_si256((__m256i *)(hashes + i), _mm512_cvtepi64_epi32(x));
+	}
+
+	multi_scalar(keys + i, n - i, hashes + i, a, b, p, c);
+}
+
+#endif
+
+// the kernel to use on this CPU, chosen on first use
+static MultiKernel kernel = NULL;
+static const char *kernel_name = NULL;
+
+// choose the widest kernel this CPU supports
+static void choose_kernel() {
+	kernel = multi_scalar;
+	kernel_name = "scalar";
+#ifdef SIMD_KERNELS
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f")) {
+		kernel = multi_avx512;
+		kernel_name = "avx512";
+	} else if (__builtin_cpu_supports("avx2")) {
+		kernel = multi_avx2;
+		kernel_name = "avx2";
+	}
+#endif
+}
+
+// hash each of the 'n' keys in 'keys' with h1, storing results in 'hashes'
+void h1_multi(int64 *keys, int n, int *hashes) {
+	if (!kernel) {
+		choose_kernel();
+	}
+	kernel(keys, n, hashes, A1, B1, p1, c1);
+}
+
+// hash each of the 'n' keys in 'keys' with h2, storing results in 'hashes'
+void h2_multi(int64 *keys, int n, int *hashes) {
+	if (!kernel) {
+		choose_kernel();
+	}
+	kernel(keys, n, hashes, A2, B2, p2, c2);
+}
+
+// name of the kernel used by h1_multi and h2_multi
+const char *hash_multi_kernel() {
+	if (!kernel) {
+		choose_kernel();
+	}
+	return kernel_name;
+}
+
+#endif
@@ -27,8 +27,13 @@ typedef uint64_t int64;
 // expression is unsigned). therefore, when returned as a 32-bit signed 
 // integer, the result will always be non-negative
 // 
-// when using these functions, remember to modulo by the size of your hash table
-// to get a valid address
+// when using these functions, remember to reduce the result to the size of your
+// hash table (with hash_address) to get a valid address
+//
+// by default the modulo by p is computed without a division (see inthash.c),
+// giving exactly the same results as the reference functions h1_ref, h2_ref
+// and h3_ref below. build with -DREFERENCE_HASH (make HASH=reference) to use
+// the reference functions and plain modulo addressing throughout instead
 
 // first available hash function
 int h1(int64 k);
@@ -36,4 +41,37 @@ int h1(int64 k);
 // second available hash function
 int h2(int64 k);
 
+// third available hash function
+int h3(int64 k);
+
+// reference implementations of h1, h2 and h3, using a 64-bit modulo
+int h1_ref(int64 k);
+int h2_ref(int64 k);
+int h3_ref(int64 k);
+
+// the 'i'th of a family of hash functions, for i >= 1: h1, h2 and h3 for
+// i = 1, 2 and 3, then h1 + (i - 3) * h3 (modulo the first prime) beyond that,
+// for tables that need more than three choices per key
+int hk(int i, int64 k);
+
+// hash each of the 'n' keys in 'keys', storing hashes[i] = h1(keys[i]) (or
+// h2) for each i. uses AVX-512 (8 keys at a time) or AVX2 (4 keys at a time)
+// when the CPU supports them, falling back to scalar code otherwise
+void h1_multi(int64 *keys, int n, int *hashes);
+void h2_multi(int64 *keys, int n, int *hashes);
+
+// name of the kernel h1_multi and h2_multi are using on this CPU:
+// "avx512", "avx2" or "scalar"
+const char *hash_multi_kernel();
+
+// reduce a hash value 'h' returned by one of the above functions to a table
+// address between 0 and 'size'-1. the division-free version multiplies the
+// 31-bit hash by 'size' and keeps the top bits (so it uses the high bits of the
+// hash, where 'h % size' uses the low bits)
+#ifdef REFERENCE_HASH
+#define hash_address(h, size) ((h) % (size))
+#else
+#define hash_address(h, size) ((int)(((int64)(h) * (int64)(size)) >> 31))
+#endif
+
 #endif
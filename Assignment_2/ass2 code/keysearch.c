@@ -0,0 +1,125 @@
+/* * * * * * * * *
+ * Module for searching an unsorted array of keys (such as a bucket) for a
+ * single key, comparing several keys at a time with vector instructions when
+ * the CPU supports them
+ *
+ * created for COMP20007 Design of Algorithms - Assignment 2, 2017
+ * by Max Philip
+ */
+
+#include "keysearch.h"
+
+// below this many keys, a plain loop beats setting up the vector compare
+#define MIN_VECTOR_KEYS 8
+
+// a search kernel reports whether 'key' is among the 'n' keys in 'keys'
+typedef bool (*SearchKernel)(int64 *keys, int n, int64 key);
+
+// scalar kernel, also used for the keys left over after the vector kernels
+static bool contain_scalar(int64 *keys, int n, int64 key) {
+	int i;
+	for (i = 0; i < n; i++) {
+		if (keys[i] == key) {
+			return true;
+		}
+	}
+	return false;
+}
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define SIMD_KERNELS
+#include <immintrin.h>
+
+// AVX2 kernel: 4 keys per compare, 16 keys per early-exit test
+__attribute__((target("avx2")))
+static bool contain_avx2(int64 *keys, int n, int64 key) {
+	__m256i k = _mm256_set1_epi64x(key);
+
+	int i;
+	for (i = 0; i + 16 <= n; i += 16) {
+		__m256i eq = _mm256_or_si256(
+			_mm256_or_si256(
+				_mm256_cmpeq_epi64(_mm256_loadu_si256((__m256i *)(keys + i)), k),
+				_mm256_cmpeq_epi64(_mm256_loadu_si256((__m256i *)(keys + i + 4)), k)),
+			_mm256_or_si256(
+				_mm256_cmpeq_epi64(_mm256_loadu_si256((__m256i *)(keys + i + 8)), k),
+				_mm256_cmpeq_epi64(_mm256_loadu_si256((__m256i *)(keys + i + 12)), k)));
+		if (!_mm256_testz_si256(eq, eq)) {
+			return true;
+		}
+	}
+	for (; i + 4 <= n; i += 4) {
+		__m256i eq = _mm256_cmpeq_epi64(
+			_mm256_loadu_si256((__m256i *)(keys + i)), k);
+		if (!_mm256_testz_si256(eq, eq)) {
+			return true;
+		}
+	}
+
+	return contain_scalar(keys + i, n - i, key);
+}
+
+// AVX-512 kernel: 8 keys per compare, 32 keys per early-exit test
+__attribute__((target("avx512f")))
+static bool contain_avx512(int64 *keys, int n, int64 key) {
+	__m512i k = _mm512_set1_epi64(key);
+
+	int i;
+	for (i = 0; i + 32 <= n; i += 32) {
+		__mmask8 eq = _mm512_cmpeq_epi64_mask(_mm512_loadu_si512(keys + i), k)
+			| _mm512_cmpeq_epi64_mask(_mm512_loadu_si512(keys + i + 8), k)
+			| _mm512_cmpeq_epi64_mask(_mm512_loadu_si512(keys + i + 16), k)
+			| _mm512_cmpeq_epi64_mask(_mm512_loadu_si512(keys + i + 24), k);
+		if (eq) {
+			return true;
+		}
+	}
+	for (; i + 8 <= n; i += 8) {
+		if (_mm512_cmpeq_epi64_mask(_mm512_loadu_si512(keys + i), k)) {
+			return true;
+		}
+	}
+
+	return contain_scalar(keys + i, n - i, key);
+}
+
+#endif
+
+// the kernel to use on this CPU, chosen on first use
+static SearchKernel kernel = NULL;
+static const char *kernel_name = NULL;
+
+// choose the widest kernel this CPU supports
+static void choose_kernel() {
+	kernel = contain_scalar;
+	kernel_name = "scalar";
+#ifdef SIMD_KERNELS
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f")) {
+		kernel = contain_avx512;
+		kernel_name = "avx512";
+	} else if (__builtin_cpu_supports("avx2")) {
+		kernel = contain_avx2;
+		kernel_name = "avx2";
+	}
+#endif
+}
+
+// is 'key' one of the 'n' keys in 'keys'?
+bool keys_contain(int64 *keys, int n, int64 key) {
+	if (n < MIN_VECTOR_KEYS) {
+		return contain_scalar(keys, n, key);
+	}
+	if (!kernel) {
+		choose_kernel();
+	}
+	return kernel(keys, n, key);
+}
+
+// name of the kernel used by keys_contain
+const char *keys_contain_kernel() {
+	if (!kernel) {
+		choose_kernel();
+	}
+	return kernel_name;
+}
@@ -0,0 +1,25 @@
+/* * * * * * * * *
+ * Module for searching an unsorted array of keys (such as a bucket) for a
+ * single key, comparing several keys at a time with vector instructions when
+ * the CPU supports them
+ *
+ * created for COMP20007 Design of Algorithms - Assignment 2, 2017
+ * by Max Philip
+ */
+
+#ifndef KEYSEARCH_H
+#define KEYSEARCH_H
+
+#include <stdbool.h>
+#include "inthash.h"
+
+// is 'key' one of the 'n' keys in 'keys'? uses AVX-512 (8 keys per compare)
+// or AVX2 (4 keys per compare) when the CPU supports them and 'n' is large
+// enough to be worth it, falling back to scalar code otherwise
+bool keys_contain(int64 *keys, int n, int64 key);
+
+// name of the kernel keys_contain is using on this CPU:
+// "avx512", "avx2" or "scalar"
+const char *keys_contain_kernel();
+
+#endif
@@ -6,20 +6,33 @@
  * by Matt Farrugia <matt.farrugia@unimelb.edu.au>
  */
 
+// for mmap, open, fstat
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
 #include <getopt.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "inthash.h"
 #include "hashtbl.h"
+#include "binary.h"
 
 // command line options
 #define DEFAULT_SIZE 4
 typedef struct options {
 	TableType type;
 	int initial_size;
+	char *binary_file;	// packed binary command file to run, or NULL to run
+						// the interactive interpreter
+	bool json_stats;	// print stats as a line of JSON (see hashstats.h)
+						// rather than as text
+	TableOptions table_options;	// options for tuning the table itself
 } Options;
 Options get_options(int argc, char** argv);
 
@@ -28,6 +41,7 @@ Options get_options(int argc, char** argv);
 
 #define INSERT 'i'
 #define LOOKUP 'l'
+#define DELETE 'd'
 #define PRINT  'p'
 #define STATS  's'
 #define HELP   'h'
@@ -35,10 +49,15 @@ Options get_options(int argc, char** argv);
 #define MAX_LINE_LEN 80
 int get_command(char *operation, int64 *key);
 
+// maximum number of consecutive insert or lookup records from a binary
+// command file to execute in one batch
+#define BINARY_BATCH 4096
+
 
 // main program
 
-void run_interpreter(HashTable *table);
+void run_interpreter(HashTable *table, bool json_stats);
+void run_binary(HashTable *table, char *filename, bool json_stats);
 
 int main(int argc, char **argv) {
 	
@@ -46,10 +65,15 @@ int main(int argc, char **argv) {
 	Options options = get_options(argc, argv);
 
 	// create hashtable (of given type)
-	HashTable *table = new_hash_table(options.type, options.initial_size);
-
-	// start the interpreter loop
-	run_interpreter(table);
+	HashTable *table = new_hash_table(options.type, options.initial_size,
+		&options.table_options);
+
+	// run the binary command file, or start the interpreter loop
+	if (options.binary_file) {
+		run_binary(table, options.binary_file, options.json_stats);
+	} else {
+		run_interpreter(table, options.json_stats);
+	}
 
 	// done!
 	free_hash_table(table);
@@ -57,16 +81,29 @@ int main(int argc, char **argv) {
 }
 
 // print out the valid operations
-void print_operations() {
+void print_operations(bool json_stats) {
 	printf(" %c number: insert 'number' into table\n",  INSERT);
 	printf(" %c number: lookup is 'number' in table\n", LOOKUP);
+	printf(" %c number: delete 'number' from table\n", DELETE);
 	printf(" %c: print table\n", PRINT);
-	printf(" %c: print stats\n", STATS);
+	printf(" %c: print stats%s\n", STATS, json_stats ? " (as JSON)" : "");
 	printf(" %c: quit\n", QUIT);
 }
 
+// print some statistics about 'table' to stdout: as text, or as a single
+// line of JSON if 'json_stats' is set
+void print_stats(HashTable *table, bool json_stats) {
+	if (json_stats) {
+		HashStats stats;
+		hash_table_get_stats(table, &stats);
+		print_hash_stats_json(stdout, &stats);
+	} else {
+		hash_table_stats(table);
+	}
+}
+
 // run the interpreter, reading and performing commands until 'quit'
-void run_interpreter(HashTable *table) {
+void run_interpreter(HashTable *table, bool json_stats) {
 	
 	// print a prompt at the beginning
 	printf("enter a command (h for help):\n");
@@ -92,10 +129,16 @@ void run_interpreter(HashTable *table) {
 				
 				} else {
 					// perform the insertion
-					if (hash_table_insert(table, key)) {
-						printf("%llu inserted\n", key);
-					} else {
-						printf("%llu already in table\n", key);
+					switch (hash_table_insert_status(table, key)) {
+						case INSERTED:
+							printf("%llu inserted\n", key);
+							break;
+						case DUPLICATE:
+							printf("%llu already in table\n", key);
+							break;
+						case REJECTED:
+							printf("%llu rejected (no room)\n", key);
+							break;
 					}
 				}
 				break;
@@ -115,6 +158,21 @@ void run_interpreter(HashTable *table) {
 				}
 				break;
 
+			case DELETE:
+				if (argc < 2) {
+					// delete commands must have an argument
+					printf("syntax: %c number\n", DELETE);
+
+				} else {
+					// perform the deletion
+					if (hash_table_delete(table, key)) {
+						printf("%llu deleted\n", key);
+					} else {
+						printf("%llu not in table\n", key);
+					}
+				}
+				break;
+
 			case PRINT:
 				// perform the print table
 				hash_table_print(table);
@@ -122,7 +180,7 @@ void run_interpreter(HashTable *table) {
 
 			case STATS:
 				// perform the print stats
-				hash_table_stats(table);
+				print_stats(table, json_stats);
 				break;
 
 			default:
@@ -132,7 +190,7 @@ void run_interpreter(HashTable *table) {
 			case HELP:
 				// list available options
 				printf("available operations:\n");
-				print_operations();
+				print_operations(json_stats);
 				break;
 				
 			case QUIT:
@@ -143,6 +201,146 @@ void run_interpreter(HashTable *table) {
 	}
 }
 
+// execute every command in the packed binary command file 'filename' (see
+// binary.h) without any text parsing, then print aggregate counters of the
+// results instead of a line per command
+void run_binary(HashTable *table, char *filename, bool json_stats) {
+
+	// map the whole command file into memory
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0) {
+		perror(filename);
+		exit(EXIT_FAILURE);
+	}
+	struct stat st;
+	if (fstat(fd, &st) < 0) {
+		perror(filename);
+		exit(EXIT_FAILURE);
+	}
+	size_t nrecords = st.st_size / BINARY_RECORD_SIZE;
+	size_t nleftover = st.st_size % BINARY_RECORD_SIZE;
+	if (nleftover > 0) {
+		// a truncated last record can't be executed, so run the rest
+		fprintf(stderr, "%s: ignoring %zu trailing bytes (not a whole "
+			"%zu-byte record)\n", filename, nleftover, BINARY_RECORD_SIZE);
+	}
+	unsigned char *records = NULL;
+	if (nrecords > 0) {
+		records = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (records == MAP_FAILED) {
+			perror(filename);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	// counters for the results of every command
+	long ninserted = 0, nduplicates = 0, nrejected = 0;
+	long nfound = 0, nnotfound = 0;
+	long ndeleted = 0, nnotdeleted = 0, nunknown = 0;
+
+	// the batch results can't tell a duplicate from a rejected key, so
+	// rejections are counted from the table's own 'rejected' stat instead
+	HashStats stats;
+	hash_table_get_stats(table, &stats);
+	long rejected = stats.rejected;
+
+	// runs of consecutive inserts or lookups are gathered into a key array
+	// and executed together through the batch interface
+	static int64 keys[BINARY_BATCH];
+	static uint8_t results[bitmap_bytes(BINARY_BATCH)];
+
+	size_t r = 0;
+	bool quit = false;
+	while (r < nrecords && !quit) {
+		unsigned char *record = records + r * BINARY_RECORD_SIZE;
+		char op = record[BINARY_OP_OFFSET];
+
+		switch (op) {
+			case INSERT:
+			case LOOKUP: {
+				// gather this run of same-opcode records (keys are unaligned
+				// inside the records, so copy them out)
+				int n = 0;
+				while (r < nrecords && n < BINARY_BATCH
+						&& records[r * BINARY_RECORD_SIZE] == op) {
+					memcpy(&keys[n++],
+						records + r * BINARY_RECORD_SIZE + BINARY_KEY_OFFSET,
+						sizeof (int64));
+					r++;
+				}
+
+				if (op == INSERT) {
+					int k = hash_table_insert_batch(table, keys, n, results);
+					ninserted += k;
+					if (k < n) {
+						// (only worth asking when some keys didn't go in)
+						hash_table_get_stats(table, &stats);
+						nrejected += stats.rejected - rejected;
+						nduplicates += n - k - (stats.rejected - rejected);
+						rejected = stats.rejected;
+					}
+				} else {
+					int k = hash_table_lookup_batch(table, keys, n, results);
+					nfound += k;
+					nnotfound += n - k;
+				}
+				continue; // r has already been advanced past the run
+			}
+
+			case DELETE: {
+				// deletes are rare enough to run one at a time
+				int64 key;
+				memcpy(&key, record + BINARY_KEY_OFFSET, sizeof (int64));
+				if (hash_table_delete(table, key)) {
+					ndeleted++;
+				} else {
+					nnotdeleted++;
+				}
+				break;
+			}
+
+			case PRINT:
+				hash_table_print(table);
+				break;
+
+			case STATS:
+				print_stats(table, json_stats);
+				break;
+
+			case QUIT:
+				quit = true;
+				break;
+
+			default:
+				nunknown++;
+				break;
+		}
+		r++;
+	}
+
+	// report aggregate results
+	printf("--- binary command results ---\n");
+	printf("     commands: %zu of %zu\n", r, nrecords);
+	printf("     inserted: %ld\n", ninserted);
+	printf("   duplicates: %ld\n", nduplicates);
+	printf("     rejected: %ld\n", nrejected);
+	printf("        found: %ld\n", nfound);
+	printf("    not found: %ld\n", nnotfound);
+	if (ndeleted + nnotdeleted > 0) {
+		printf("      deleted: %ld\n", ndeleted);
+		printf("  not deleted: %ld\n", nnotdeleted);
+	}
+	if (nunknown > 0) {
+		printf(" unknown ops: %ld\n", nunknown);
+	}
+	printf("--- end results ---\n");
+
+	if (records) {
+		munmap(records, st.st_size);
+	}
+	close(fd);
+}
+
 // reads a line from stdin, parses it into an operation character and possibly
 // a long long uinteger argument. store results in *operation and *key, resp.
 //
@@ -172,11 +370,14 @@ int get_command(char *operation, int64 *key) {
 Options get_options(int argc, char** argv) {
 	
 	// create the Options structure with defaults
-	Options options = { .type = NOTYPE, .initial_size = DEFAULT_SIZE };
+	Options options = { .type = NOTYPE, .initial_size = DEFAULT_SIZE,
+		.binary_file = NULL, .json_stats = false };
+	default_table_options(&options.table_options);
+	bool valid_table_options = true;
 
 	// use C's built-in getopt function to scan inputs by flag
 	char option;
-	while ((option = getopt(argc, argv, "t:s:")) != EOF){
+	while ((option = getopt(argc, argv, "t:s:b:o:j")) != EOF){
 		switch (option){
 			case 't': // set hash table type
 				options.type = strtotype(optarg);
@@ -184,6 +385,16 @@ Options get_options(int argc, char** argv) {
 			case 's': // set hash table size
 				options.initial_size = atoi(optarg);
 				break;
+			case 'b': // run a packed binary command file instead of stdin
+				options.binary_file = optarg;
+				break;
+			case 'j': // print stats as JSON
+				options.json_stats = true;
+				break;
+			case 'o': // set table options
+				valid_table_options = valid_table_options
+					&& parse_table_options(optarg, &options.table_options);
+				break;
 			default:
 				break;
 		}
@@ -202,6 +413,10 @@ Options get_options(int argc, char** argv) {
 		fprintf(stderr,
 			" -t 2 or xtnbdln: n-key extendible hash table (part 2)\n");
 		fprintf(stderr, " -t 3 or xuckoo:  extendible cuckoo table (part 3)\n");
+		fprintf(stderr, " -t swiss:   swisstable-style control byte table\n");
+		fprintf(stderr, " -t xtndblt: multi-level (trie) extendible table\n");
+		fprintf(stderr, " -t xuckoon: n-key extendible cuckoo table\n");
+		fprintf(stderr, " -t cuckoo3: 3-ary cuckoo hash table\n");
 		valid = false;
 	}
 
@@ -212,6 +427,14 @@ Options get_options(int argc, char** argv) {
 		valid = false;
 	}
 
+	// validate table options
+	if (!valid_table_options) {
+		fprintf(stderr,
+			"invalid table option; available options for the -o flag:\n");
+		print_table_options(stderr);
+		valid = false;
+	}
+
 	// check overall validity before continuing
 	if(!valid){
 		exit(EXIT_FAILURE);
@@ -0,0 +1,177 @@
+/* * * * * * * * *
+ * Module containing tunable options for the various hash tables, which can be
+ * given to the a2 program as a comma-separated list with the -o flag,
+ * e.g. '-o sentinel' or '-o sentinel=0'
+ *
+ * created for COMP20007 Design of Algorithms - Assignment 2, 2017
+ * by Max Philip
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "options.h"
+
+// how many old slots to migrate per operation for a bare 'incremental' option
+#define DEFAULT_MIGRATE 16
+
+// largest cuckoo bucket: 8 keys fill a 64-byte cache line
+#define MAX_BUCKET_SIZE 8
+
+// longest cuckoo eviction path to search for with a bare 'bfs' option
+#define DEFAULT_BFS_DEPTH 5
+
+// largest overflow stash: it is searched linearly on every lookup
+#define MAX_STASH_SIZE 64
+
+// deepest extendible bucket: a directory of 2^26 entries is the largest below
+// MAX_TABLE_SIZE (see inthash.h)
+#define MAX_MAX_DEPTH 26
+
+// default deepest extendible bucket: a directory of 2^20 entries takes 8MB
+// (per inner table, for xuckoo and xuckoon)
+#define DEFAULT_MAX_DEPTH 20
+
+// longest overflow chain: it is searched linearly on every lookup
+#define MAX_MAX_CHAIN 64
+#define DEFAULT_MAX_CHAIN 8
+
+// set every option in 'options' to its default value
+void default_table_options(TableOptions *options) {
+	assert(options);
+	options->sentinel = false;
+	options->robin_hood = false;
+	options->max_load = 1.0;
+	options->growth = 2.0;
+	options->migrate = 0;
+	options->bucket_size = 1;
+	options->bfs_depth = 0;
+	options->stash_size = 0;
+	options->sorted = false;
+	options->max_depth = DEFAULT_MAX_DEPTH;
+	options->max_chain = DEFAULT_MAX_CHAIN;
+	options->lazy_directory = false;
+}
+
+// interpret the value of a flag option: a flag with no value is switched on
+static bool flag_value(char *value) {
+	return value == NULL || atoi(value) != 0;
+}
+
+// set the option called 'name' to 'value' (which may be NULL)
+// returns true if there is such an option and 'value' is valid for it,
+// false if not
+static bool set_option(TableOptions *options, char *name, char *value) {
+	if (strcmp(name, "sentinel") == 0) {
+		options->sentinel = flag_value(value);
+		return true;
+	}
+	if (strcmp(name, "robinhood") == 0) {
+		options->robin_hood = flag_value(value);
+		return true;
+	}
+	if (strcmp(name, "maxload") == 0 && value) {
+		options->max_load = atof(value);
+		return options->max_load > 0 && options->max_load <= 1;
+	}
+	if (strcmp(name, "growth") == 0 && value) {
+		options->growth = atof(value);
+		return options->growth > 1;
+	}
+	if (strcmp(name, "incremental") == 0) {
+		options->migrate = value ? atoi(value) : DEFAULT_MIGRATE;
+		return options->migrate >= 0;
+	}
+	if (strcmp(name, "bucket") == 0 && value) {
+		options->bucket_size = atoi(value);
+		return options->bucket_size >= 1
+			&& options->bucket_size <= MAX_BUCKET_SIZE;
+	}
+	if (strcmp(name, "bfs") == 0) {
+		options->bfs_depth = value ? atoi(value) : DEFAULT_BFS_DEPTH;
+		return options->bfs_depth >= 0;
+	}
+	if (strcmp(name, "stash") == 0 && value) {
+		options->stash_size = atoi(value);
+		return options->stash_size >= 0
+			&& options->stash_size <= MAX_STASH_SIZE;
+	}
+	if (strcmp(name, "sorted") == 0) {
+		options->sorted = flag_value(value);
+		return true;
+	}
+	if (strcmp(name, "maxdepth") == 0 && value) {
+		options->max_depth = atoi(value);
+		return options->max_depth >= 0 && options->max_depth <= MAX_MAX_DEPTH;
+	}
+	if (strcmp(name, "maxchain") == 0 && value) {
+		options->max_chain = atoi(value);
+		return options->max_chain >= 0 && options->max_chain <= MAX_MAX_CHAIN;
+	}
+	if (strcmp(name, "lazydir") == 0) {
+		options->lazy_directory = flag_value(value);
+		return true;
+	}
+	return false;
+}
+
+// parse a comma-separated list of options of the form 'name' (for switching
+// on a flag) or 'name=value' from 'str' into 'options'
+// returns true if every option was recognised and valid, false otherwise
+bool parse_table_options(char *str, TableOptions *options) {
+	assert(str && options);
+
+	// work on a copy, since strtok modifies the string it splits
+	char *copy = malloc(strlen(str) + 1);
+	assert(copy);
+	strcpy(copy, str);
+
+	bool valid = true;
+	char *name;
+	for (name = strtok(copy, ","); name; name = strtok(NULL, ",")) {
+		// split 'name=value' into separate strings
+		char *value = strchr(name, '=');
+		if (value) {
+			*value++ = '\0';
+		}
+		if (!set_option(options, name, value)) {
+			valid = false;
+		}
+	}
+
+	free(copy);
+	return valid;
+}
+
+// print a list of the available options and their defaults to 'stream'
+void print_table_options(FILE *stream) {
+	fprintf(stream, " sentinel[=0|1]: linear: mark empty slots with a reserved"
+		" key (default 0)\n");
+	fprintf(stream, " robinhood[=0|1]: linear: robin hood insertion, bounding"
+		" misses (default 0)\n");
+	fprintf(stream, " maxload=x: linear, cuckoo, cuckoo3, swiss: grow before"
+		" load factor exceeds x, 0 < x <= 1 (default 1, swiss at most"
+		" 0.875)\n");
+	fprintf(stream, " growth=x: linear, cuckoo, cuckoo3, swiss: multiply size"
+		" by x > 1 when growing (default 2)\n");
+	fprintf(stream, " incremental[=n]: linear: resize incrementally, moving n"
+		" old slots per operation (default off, n=%d)\n", DEFAULT_MIGRATE);
+	fprintf(stream, " bucket=n: cuckoo: keys per bucket, 1 <= n <= %d"
+		" (default 1)\n", MAX_BUCKET_SIZE);
+	fprintf(stream, " bfs[=d]: cuckoo: insert via breadth-first search for an"
+		" eviction path of at most d moves (default off, d=%d)\n",
+		DEFAULT_BFS_DEPTH);
+	fprintf(stream, " stash=n: cuckoo, xuckoo, xuckoon: overflow stash for keys"
+		" caught in cycles, 0 <= n <= %d (default 0)\n", MAX_STASH_SIZE);
+	fprintf(stream, " sorted[=0|1]: xtndbln: keep bucket keys sorted and binary"
+		" search them (default 0)\n");
+	fprintf(stream, " maxdepth=n: extendible tables: split buckets to at most"
+		" n hash bits, then chain overflow buckets, 0 <= n <= %d"
+		" (default %d)\n", MAX_MAX_DEPTH, DEFAULT_MAX_DEPTH);
+	fprintf(stream, " maxchain=n: extendible tables: chain at most n overflow"
+		" buckets on a bucket, then refuse insertions, 0 <= n <= %d"
+		" (default %d)\n", MAX_MAX_CHAIN, DEFAULT_MAX_CHAIN);
+	fprintf(stream, " lazydir[=0|1]: xtndbl1, xtndbln, xuckoo, xuckoon: double"
+		" the directory without copying it (default 0)\n");
+}
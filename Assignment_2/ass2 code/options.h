@@ -0,0 +1,61 @@
+/* * * * * * * * *
+ * Module containing tunable options for the various hash tables, which can be
+ * given to the a2 program as a comma-separated list with the -o flag,
+ * e.g. '-o sentinel' or '-o sentinel=0'
+ *
+ * created for COMP20007 Design of Algorithms - Assignment 2, 2017
+ * by Max Philip
+ */
+
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+// options structure; tables ignore any options that don't apply to them
+typedef struct table_options {
+	bool sentinel;	// linear: mark empty slots with a reserved key instead of
+					// keeping a separate array of in-use flags
+	bool robin_hood;// linear: use robin hood insertion, to bound the length
+					// of unsuccessful lookups
+
+	// resize policy (linear, cuckoo, cuckoo3, swiss)
+	double max_load;// grow before the fraction of slots in use exceeds this
+	double growth;	// factor to multiply the table size by when growing
+	int migrate;	// linear: if nonzero, resize incrementally, moving this
+					// many old slots per operation (0: stop-the-world)
+	int bucket_size;// cuckoo: number of keys in each bucket (1 for classic
+					// one-key-per-slot cuckoo hashing)
+	int bfs_depth;	// cuckoo: if nonzero, insert by breadth-first search for
+					// an eviction path of at most this many moves, instead
+					// of evicting keys until a cycle is found
+	int stash_size;	// cuckoo, xuckoo, xuckoon: number of keys the overflow
+					// stash can hold (for keys caught in a cycle) before
+					// growing
+	bool sorted;	// xtndbln: keep each bucket's keys sorted and binary
+					// search them, instead of scanning every key
+	int max_depth;	// extendible tables: most hash value bits a bucket
+					// can use; a full bucket at this depth chains on
+					// overflow buckets instead of splitting, capping the
+					// directory at 2^max_depth entries
+	int max_chain;	// extendible tables: most overflow buckets a bucket
+					// can chain on; an insertion that would need another
+					// one fails instead
+	bool lazy_directory;// xtndbl1, xtndbln, xuckoo, xuckoon: grow the
+					// directory without copying it, materialising its
+					// entries only as buckets split into them
+} TableOptions;
+
+// set every option in 'options' to its default value
+void default_table_options(TableOptions *options);
+
+// parse a comma-separated list of options of the form 'name' (for switching
+// on a flag) or 'name=value' from 'str' into 'options'
+// returns true if every option was recognised and valid, false otherwise
+bool parse_table_options(char *str, TableOptions *options);
+
+// print a list of the available options and their defaults to 'stream'
+void print_table_options(FILE *stream);
+
+#endif
@@ -0,0 +1,138 @@
+/* * * * * * * * *
+ * Module for allocating many small objects of one fixed size (such as hash
+ * table buckets) out of a few large pages, so that they sit next to each
+ * other in memory and can all be freed at once
+ *
+ * created for COMP20007 Design of Algorithms - Assignment 2, 2017
+ * by Max Philip
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include "slab.h"
+
+// pages start small, so that small tables stay small, and double in size up
+// to a limit, so that big tables only need a few hundred pages
+#define FIRST_PAGE_BYTES 4096
+#define MAX_PAGE_BYTES (1 << 20)
+
+// objects are aligned for the largest type they hold (64-bit keys/pointers)
+#define ALIGNMENT (sizeof (int64_t))
+
+// a page is a header followed by space for a number of objects
+typedef struct page {
+	struct page *next;	// the previously allocated page
+	size_t bytes;		// size of this page including the header
+} Page;
+
+// a released object holds a pointer to the next released object
+typedef struct free_object {
+	struct free_object *next;
+} FreeObject;
+
+struct slab {
+	size_t object_size;	// bytes per object, rounded up to the alignment
+	Page *pages;		// the most recently allocated page (list of pages)
+	char *next;			// the next unused object in the current page
+	char *end;			// the end of the current page
+	FreeObject *free;	// released objects, ready for reuse
+	size_t page_bytes;	// how big the next page will be
+	size_t bytes;		// total bytes held in pages
+};
+
+// offset of the first object in a page, keeping objects aligned
+#define PAGE_HEADER (((sizeof (Page)) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT)
+
+
+// create a new slab handing out objects of 'object_size' bytes each
+Slab *new_slab(size_t object_size) {
+	Slab *slab = malloc(sizeof *slab);
+	assert(slab);
+
+	// a released object has to be able to hold the free list link
+	if (object_size < sizeof (FreeObject)) {
+		object_size = sizeof (FreeObject);
+	}
+	slab->object_size = (object_size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+	slab->pages = NULL;
+	slab->next = NULL;
+	slab->end = NULL;
+	slab->free = NULL;
+	slab->page_bytes = FIRST_PAGE_BYTES;
+	slab->bytes = 0;
+
+	return slab;
+}
+
+// free a slab along with every object allocated from it
+void free_slab(Slab *slab) {
+	assert(slab);
+
+	while (slab->pages) {
+		Page *next = slab->pages->next;
+		free(slab->pages);
+		slab->pages = next;
+	}
+	free(slab);
+}
+
+// start a new page big enough for at least one object
+static void add_page(Slab *slab) {
+	size_t bytes = slab->page_bytes;
+	if (bytes < PAGE_HEADER + slab->object_size) {
+		bytes = PAGE_HEADER + slab->object_size;
+	}
+
+	Page *page = malloc(bytes);
+	assert(page);
+	page->next = slab->pages;
+	page->bytes = bytes;
+	slab->pages = page;
+	slab->bytes += bytes;
+
+	slab->next = (char *)page + PAGE_HEADER;
+	slab->end = (char *)page + bytes;
+
+	if (slab->page_bytes < MAX_PAGE_BYTES) {
+		slab->page_bytes *= 2;
+	}
+}
+
+// allocate an (uninitialised) object from 'slab'
+void *slab_alloc(Slab *slab) {
+	assert(slab);
+
+	// reuse a released object if there is one
+	if (slab->free) {
+		FreeObject *object = slab->free;
+		slab->free = object->next;
+		return object;
+	}
+
+	// otherwise take the next object from the current page, starting a new
+	// page if it's full
+	if (slab->next == NULL
+			|| (size_t)(slab->end - slab->next) < slab->object_size) {
+		add_page(slab);
+	}
+	void *object = slab->next;
+	slab->next += slab->object_size;
+	return object;
+}
+
+// give an object allocated from 'slab' back, for reuse by a later slab_alloc
+void slab_release(Slab *slab, void *object) {
+	assert(slab && object);
+
+	FreeObject *released = object;
+	released->next = slab->free;
+	slab->free = released;
+}
+
+// total bytes of memory held by 'slab' (including unused space)
+size_t slab_bytes(Slab *slab) {
+	assert(slab);
+	return slab->bytes;
+}
@@ -0,0 +1,33 @@
+/* * * * * * * * *
+ * Module for allocating many small objects of one fixed size (such as hash
+ * table buckets) out of a few large pages, so that they sit next to each
+ * other in memory and can all be freed at once
+ *
+ * created for COMP20007 Design of Algorithms - Assignment 2, 2017
+ * by Max Philip
+ */
+
+#ifndef SLAB_H
+#define SLAB_H
+
+#include <stddef.h>
+
+typedef struct slab Slab;
+
+// create a new slab handing out objects of 'object_size' bytes each
+Slab *new_slab(size_t object_size);
+
+// free a slab along with every object allocated from it
+void free_slab(Slab *slab);
+
+// allocate an (uninitialised) object from 'slab'
+void *slab_alloc(Slab *slab);
+
+// give an object allocated from 'slab' back, for reuse by a later slab_alloc
+// (its memory stays part of the slab until the slab itself is freed)
+void slab_release(Slab *slab, void *object);
+
+// total bytes of memory held by 'slab' (including unused space)
+size_t slab_bytes(Slab *slab);
+
+#endif
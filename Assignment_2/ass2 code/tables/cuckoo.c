@@ -8,63 +8,217 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
+#include <time.h>
 
 #include "cuckoo.h"
+#include "../batch.h"
 
 void cuckoo_hash_table_print(CuckooHashTable *table);
 bool cuckoo_hash_table_insert(CuckooHashTable *table, int64 key);
 bool cuckoo_hash_table_lookup(CuckooHashTable *table, int64 key);
+static bool insert_hashed(CuckooHashTable *table, int64 key, int hash);
+
+// in bucketized mode, or during a resize, how many evictions an insertion may
+// make before giving up and growing the table (in either case, the walk isn't
+// sure to revisit its start)
+#define MAX_EVICTIONS 500
+
+// most slots a breadth-first search for an eviction path may visit (the
+// search tree grows as bucket_size^depth, so large buckets need a cap)
+#define MAX_BFS_NODES 4096
 
 
 // an inner table represents one of the two internal tables for a cuckoo
 // hash table. it stores two parallel arrays: 'slots' for storing keys and
 // 'inuse' for marking which entries are occupied
+//
+// the arrays of both inner tables share a single allocation, laid out as
+// [ slots1 | slots2 | inuse1 | inuse2 ], which is grown in place
 typedef struct inner_table {
 	int64 *slots;	// array of slots holding keys
 	bool  *inuse;	// is this slot in use or not?
 } InnerTable;
 
+// a node in the breadth-first search for an eviction path: a full slot whose
+// key could be moved to its other bucket, and the node whose key would then
+// move into this slot
+typedef struct bfs_node {
+	int table;	// which inner table the slot is in (1 or 2)
+	int slot;	// address of the slot within that table
+	int parent;	// index of the previous node on the path, or -1 for a slot
+				// the new key itself could go in
+	int depth;	// how many moves the path up to and including this slot needs
+} BfsNode;
+
 // a cuckoo hash table stores its keys in two inner tables
+//
+// in bucketized mode, the slots of each inner table are grouped into buckets
+// of 'bucket_size' consecutive slots, and a key's hash picks a bucket rather
+// than a single slot. a key can go in any slot of either of its two buckets,
+// so far fewer insertions need evictions, and the tables can fill much
+// further before a cycle forces them to grow
 struct cuckoo_table {
 	InnerTable *table1; // first table
 	InnerTable *table2; // second table
-	int size;			// size of each table
+	void *block;		// the single allocation holding all four arrays
+	int size;			// number of slots in each table
+	int nbuckets;		// number of buckets in each table
+	int bucket_size;	// number of slots in each bucket (1 for classic cuckoo)
+	int load;			// number of keys in both tables together
+
+	double max_load;	// grow once more than this fraction of slots are full
+	double growth;		// factor to grow the tables by each time
+	int nresizes;		// how many times the tables have been resized
+	long resize_time;	// how much CPU time has been spent resizing
+	bool resizing;		// is a resize in progress right now?
+
+	int bfs_depth;		// bfs mode: longest eviction path to look for (0: off)
+	BfsNode *bfs_queue;	// bfs mode: queue of slots to search from
+	int bfs_capacity;	// bfs mode: most nodes the queue can hold
+	int bfs_failures;	// bfs mode: searches that found no path (and grew)
+
+	int64 *stash;		// overflow stash for keys that couldn't be placed
+	int stash_size;		// how many keys the stash can hold
+	int stash_load;		// how many keys are in the stash right now
+	int nstashed;		// how many times a key has been put in the stash
+	int nforced;		// how many resizes were forced by a full stash (or a
+						// cycle, with no stash), rather than the load factor
+	long ninserts;		// how many keys have been inserted (for resize rate)
+	long nevictions;	// how many keys have been moved to their other table
 };
 
 
-// initialise a cuckoo hash table with 'size' slots in each table
-CuckooHashTable *new_cuckoo_hash_table(int size) {
+// the number of bytes needed to hold the arrays of two inner tables of
+// 'size' slots
+static size_t block_bytes(int size) {
+	return (sizeof (int64) + sizeof (bool)) * 2 * (size_t)size;
+}
+
+
+// point the arrays of both inner tables into 'table->block', for tables of
+// 'size' slots
+static void layout_tables(CuckooHashTable *table, int size) {
+	table->table1->slots = table->block;
+	table->table2->slots = table->table1->slots + size;
+	table->table1->inuse = (bool *)(table->table2->slots + size);
+	table->table2->inuse = table->table1->inuse + size;
+}
+
+
+// set up both inner tables with new arrays of 'nbuckets' buckets
+static void initialise_tables(CuckooHashTable *table, int nbuckets) {
+	int size = nbuckets * table->bucket_size;
 
 	// error message taken from linear.c file
 	assert(size < MAX_TABLE_SIZE && "error: table has grown too large!");
 
-	CuckooHashTable *table = malloc(sizeof *table);
-	//assert(table);
+	table->block = malloc(block_bytes(size));
+	assert(table->block);
+	layout_tables(table, size);
 
-	//printf("fuckuasshole");
+	// set all slots as not having a key
+	memset(table->table1->inuse, false, (sizeof *table->table1->inuse) * size);
+	memset(table->table2->inuse, false, (sizeof *table->table2->inuse) * size);
 
-	table->table1 = malloc((sizeof *table->table1) * size);
-	table->table2 = malloc((sizeof *table->table2) * size);
+	table->size = size;
+	table->nbuckets = nbuckets;
+}
 
-	table->table1->slots = malloc((sizeof *table->table1->slots) * size);
-	assert(table->table1->slots);
-	table->table2->slots = malloc((sizeof *table->table2->slots) * size);
-	assert(table->table2->slots);
 
-	table->table1->inuse = malloc((sizeof *table->table1->inuse) * size);
-	assert(table->table1->inuse);
-	table->table2->inuse = malloc((sizeof *table->table2->inuse) * size);
-	assert(table->table2->inuse);
+// grow the arrays of both inner tables to 'nbuckets' buckets in place, keeping
+// every key at the same address (and marking the new slots as free)
+static void grow_tables(CuckooHashTable *table, int nbuckets) {
+	int oldsize = table->size;
+	int size = nbuckets * table->bucket_size;
+	assert(size < MAX_TABLE_SIZE && "error: table has grown too large!");
 
-	// set all slots as not having a key
-	int i;
-	for (i = 0; i < size; i++) {
-		table->table1->inuse[i] = false;
-		table->table2->inuse[i] = false;
-	}
+	// (for large blocks, realloc can usually remap pages rather than copy)
+	table->block = realloc(table->block, block_bytes(size));
+	assert(table->block);
+
+	// where the arrays are in the block now, at the old layout
+	int64 *oldslots2 = (int64 *)table->block + oldsize;
+	bool  *oldinuse1 = (bool *)(oldslots2 + oldsize);
+	bool  *oldinuse2 = oldinuse1 + oldsize;
+
+	// every array but the first moves further along the block: move the last
+	// one first, so none is overwritten before it has moved
+	layout_tables(table, size);
+	memmove(table->table2->inuse, oldinuse2,
+		(sizeof *table->table2->inuse) * oldsize);
+	memmove(table->table1->inuse, oldinuse1,
+		(sizeof *table->table1->inuse) * oldsize);
+	memmove(table->table2->slots, oldslots2,
+		(sizeof *table->table2->slots) * oldsize);
+
+	memset(table->table1->inuse + oldsize, false,
+		(sizeof *table->table1->inuse) * (size - oldsize));
+	memset(table->table2->inuse + oldsize, false,
+		(sizeof *table->table2->inuse) * (size - oldsize));
 
 	table->size = size;
+	table->nbuckets = nbuckets;
+}
+
+
+// initialise a cuckoo hash table with 'size' slots in each table (rounded up
+// to whole buckets of 'options->bucket_size' slots), growing according to the
+// resize policy in 'options'
+CuckooHashTable *new_cuckoo_hash_table(int size, TableOptions *options) {
+
+	CuckooHashTable *table = malloc(sizeof *table);
+	assert(table);
+
+	table->table1 = malloc(sizeof *table->table1);
+	assert(table->table1);
+	table->table2 = malloc(sizeof *table->table2);
+	assert(table->table2);
+
+	table->bucket_size = options->bucket_size;
+	initialise_tables(table,
+		(size + table->bucket_size - 1) / table->bucket_size);
+	table->load = 0;
+
+	table->max_load = options->max_load;
+	table->growth = options->growth;
+	table->nresizes = 0;
+	table->resize_time = 0;
+	table->resizing = false;
+
+	// the search for an eviction path visits at most 2b + 2b^2 + ... + 2b^d
+	// slots, for buckets of b slots and paths of up to d moves
+	table->bfs_depth = options->bfs_depth;
+	table->bfs_queue = NULL;
+	table->bfs_capacity = 0;
+	table->bfs_failures = 0;
+	if (table->bfs_depth > 0) {
+		int d, level = 2;
+		for (d = 0; d < table->bfs_depth
+				&& table->bfs_capacity < MAX_BFS_NODES; d++) {
+			level *= table->bucket_size;
+			table->bfs_capacity += level;
+		}
+		if (table->bfs_capacity > MAX_BFS_NODES) {
+			table->bfs_capacity = MAX_BFS_NODES;
+		}
+		table->bfs_queue = malloc((sizeof *table->bfs_queue)
+			* table->bfs_capacity);
+		assert(table->bfs_queue);
+	}
+
+	// keys caught in a cycle go in the stash, and only once it's full does
+	// the table grow
+	table->stash_size = options->stash_size;
+	table->stash_load = 0;
+	table->nstashed = 0;
+	table->nforced = 0;
+	table->ninserts = 0;
+	table->nevictions = 0;
+	table->stash = malloc((sizeof *table->stash)
+		* (table->stash_size > 0 ? table->stash_size : 1));
+	assert(table->stash);
 
 	return table;
 }
@@ -74,103 +228,284 @@ CuckooHashTable *new_cuckoo_hash_table(int size) {
 void free_cuckoo_hash_table(CuckooHashTable *table) {
 	assert(table != NULL);
 
-	free(table->table1->slots);
-	free(table->table2->slots);
-
-	free(table->table1->inuse);
-	free(table->table2->inuse);
+	free(table->block);
 
 	free(table->table1);
 	free(table->table2);
+	free(table->bfs_queue);
+	free(table->stash);
 
 	free(table);
 }
 
 
-CuckooHashTable *cuck_double_table(CuckooHashTable *table) {
-	int64 *oldslots1 = table->table1->slots;
-	int64 *oldslots2 = table->table2->slots;
-	bool  *oldinuse1 = table->table1->inuse;
-	bool  *oldinuse2 = table->table2->inuse;
+// resize both inner tables to 'nbuckets' buckets, and re-hash all keys into
+// them in place
+static void resize_table(CuckooHashTable *table, int nbuckets) {
 	int oldsize = table->size;
 
+	// re-inserting keys can trigger another resize: only time the outermost
+	bool outermost = !table->resizing;
+	table->resizing = true;
+	long start_time = clock();
+
+	// take the keys out of the stash, to re-insert after the others
+	int nstashed = table->stash_load;
+	int64 *stashed = malloc((sizeof *stashed) * (nstashed > 0 ? nstashed : 1));
+	assert(stashed);
+	memcpy(stashed, table->stash, (sizeof *stashed) * nstashed);
+	table->stash_load = 0;
+
+	grow_tables(table, nbuckets);
+
+	// now move every key that isn't in its bucket for the new size. a key is
+	// taken out of its slot and inserted again: this can evict keys that
+	// haven't been moved yet, but they then land in one of their new buckets
+	// too, so by the end, every key is somewhere it can be found
+	// (re-read the arrays each time: a cycle could grow them again)
+	int i, t;
+	for (i = 0; i < oldsize; i++) {
+		for (t = 1; t <= 2; t++) {
+			InnerTable *inner = t == 1 ? table->table1 : table->table2;
+			if (!inner->inuse[i]) {
+				continue;
+			}
+			int64 key = inner->slots[i];
+			int hash = t == 1 ? h1(key) : h2(key);
+			if (hash_address(hash, table->nbuckets) == i / table->bucket_size) {
+				continue;
+			}
+			inner->inuse[i] = false;
+			insert_hashed(table, key, h1(key));
+		}
+	}
+	for (i = 0; i < nstashed; i++) {
+		insert_hashed(table, stashed[i], h1(stashed[i]));
+	}
+	free(stashed);
+
+	table->nresizes++;
+	if (outermost) {
+		table->resize_time += clock() - start_time;
+		table->resizing = false;
+	}
+}
+
+
+// the number of buckets to grow the inner tables of 'table' to next
+static int grown_size(CuckooHashTable *table) {
+	int nbuckets = table->nbuckets * table->growth;
+	return nbuckets > table->nbuckets ? nbuckets : table->nbuckets + 1;
+}
+
+
+// put 'key' in a free slot of bucket 'h' of 'inner', if it has one
+// returns true if the key was placed, false if the bucket is full
+static bool place_in_bucket(CuckooHashTable *table, InnerTable *inner, int h,
+	int64 key) {
+	int i;
+	for (i = h * table->bucket_size; i < (h + 1) * table->bucket_size; i++) {
+		if (!inner->inuse[i]) {
+			inner->slots[i] = key;
+			inner->inuse[i] = true;
+			return true;
+		}
+	}
+	return false;
+}
 
-	// new table as double the size
-	table = new_cuckoo_hash_table(oldsize * 2);
 
-	// insert all the old keys after doubling
+// swap 'key' into slot 'victim' of bucket 'h' of 'inner' (which is full)
+// returns the key that was evicted from that slot
+static int64 evict_from_bucket(CuckooHashTable *table, InnerTable *inner,
+	int h, int victim, int64 key) {
+	int i = h * table->bucket_size + victim;
+	int64 evicted = inner->slots[i];
+	inner->slots[i] = key;
+	table->nevictions++;
+	return evicted;
+}
+
+
+// deal with 'key', which couldn't be placed in 'table' without a cycle: put it
+// in the stash if there's room, otherwise grow the table and insert it again
+static bool stash_or_grow(CuckooHashTable *table, int64 key) {
+	if (table->stash_load < table->stash_size) {
+		table->stash[table->stash_load++] = key;
+		table->nstashed++;
+		return true;
+	}
+
+	table->nforced++;
+	resize_table(table, grown_size(table));
+	return insert_hashed(table, key, h1(key));
+}
+
+
+// the inner table numbered 't' (1 or 2) of 'table'
+static InnerTable *inner_table(CuckooHashTable *table, int t) {
+	return t == 1 ? table->table1 : table->table2;
+}
+
+
+// find a free slot in bucket 'h' of 'inner'
+// returns the slot's address, or -1 if the bucket is full
+static int free_slot(CuckooHashTable *table, InnerTable *inner, int h) {
 	int i;
-	for (i = 0; i < oldsize; i++){
-		if (oldinuse1[i] == true){
-			cuckoo_hash_table_insert(table, oldslots1[i]);
+	for (i = h * table->bucket_size; i < (h + 1) * table->bucket_size; i++) {
+		if (!inner->inuse[i]) {
+			return i;
 		}
-		if (oldinuse2[i] == true){
-			cuckoo_hash_table_insert(table, oldslots2[i]);
+	}
+	return -1;
+}
+
+
+// is slot 'slot' of inner table 't' on the eviction path ending at node 'n'?
+static bool on_path(CuckooHashTable *table, int n, int t, int slot) {
+	for (; n >= 0; n = table->bfs_queue[n].parent) {
+		if (table->bfs_queue[n].table == t && table->bfs_queue[n].slot == slot) {
+			return true;
 		}
 	}
+	return false;
+}
 
-	// free allocated memory
-	free(oldslots1);
-	free(oldslots2);
-	free(oldinuse1);
-	free(oldinuse2);
 
-	return table;
+// add the slots of the full bucket 'h' of inner table 't' to the end of the
+// search queue (of length '*tail'), as the next moves after node 'parent'
+// (skipping slots already on that path, and any that don't fit in the queue)
+static void enqueue_bucket(CuckooHashTable *table, int *tail, int t, int h,
+	int parent, int depth) {
+	int i;
+	for (i = h * table->bucket_size; i < (h + 1) * table->bucket_size
+			&& *tail < table->bfs_capacity; i++) {
+		if (!on_path(table, parent, t, i)) {
+			BfsNode node = {t, i, parent, depth};
+			table->bfs_queue[(*tail)++] = node;
+		}
+	}
 }
 
 
-// insert 'key' into 'table', if it's not in there already
-// returns true if insertion succeeds, false if it was already in there
-bool cuckoo_hash_table_insert(CuckooHashTable *table, int64 key) {
-	//fprintf(stderr, "not yet implemented\n");
-	assert(table != NULL);
+// bfs mode: insert 'key', which is not already in 'table', given its h1 hash
+// value 'hash'. search breadth-first for the shortest path of evictions that
+// ends in a free slot, and only then move the keys along it. if there's no
+// path of at most bfs_depth moves, grow the table instead
+static bool bfs_insert(CuckooHashTable *table, int64 key, int hash) {
+	int bucket1 = hash_address(hash, table->nbuckets);
+	int bucket2 = hash_address(h2(key), table->nbuckets);
+	if (place_in_bucket(table, table->table1, bucket1, key)
+		|| place_in_bucket(table, table->table2, bucket2, key)) {
+		return true;
+	}
+
+	// both buckets are full: search outwards from every slot in them
+	int head = 0, tail = 0;
+	enqueue_bucket(table, &tail, 1, bucket1, -1, 1);
+	enqueue_bucket(table, &tail, 2, bucket2, -1, 1);
+
+	while (head < tail) {
+		int n = head++;
+		BfsNode node = table->bfs_queue[n];
+
+		// the key in this slot would move to its bucket in the other table
+		int64 moving = inner_table(table, node.table)->slots[node.slot];
+		int t = node.table == 1 ? 2 : 1;
+		int h = hash_address(t == 1 ? h1(moving) : h2(moving), table->nbuckets);
+		int dest = free_slot(table, inner_table(table, t), h);
+
+		if (dest >= 0) {
+			// found a path! move each key one step along it, starting from
+			// the free slot at the end, so no key is ever displaced
+			for (; n >= 0; n = table->bfs_queue[n].parent) {
+				BfsNode step = table->bfs_queue[n];
+				InnerTable *from = inner_table(table, step.table);
+				InnerTable *to = inner_table(table, t);
+				to->slots[dest] = from->slots[step.slot];
+				to->inuse[dest] = true;
+				table->nevictions++;
+				t = step.table;
+				dest = step.slot;
+			}
+
+			// which leaves the first slot on the path for the new key
+			inner_table(table, t)->slots[dest] = key;
+			return true;
+		}
 
-	//cuckoo_hash_table_print(table);
+		if (node.depth < table->bfs_depth) {
+			enqueue_bucket(table, &tail, t, h, n, node.depth + 1);
+		}
+	}
+
+	// no short enough path: stash the key, or grow the table
+	table->bfs_failures++;
+	return stash_or_grow(table, key);
+}
 
-	int h = h1(key) % table->size;
-	//printf("%llu: h1: %d,    h2: %d\n", key, h, h2(key)%table->size);
+
+// insert 'key', which is not already in 'table', given its h1 hash value
+// 'hash', evicting keys between the two tables as necessary
+static bool insert_hashed(CuckooHashTable *table, int64 key, int hash) {
+
+	if (table->bfs_depth > 0) {
+		return bfs_insert(table, key, hash);
+	}
+
+	int h = hash_address(hash, table->nbuckets);
+
+	// in bucketized mode, look for room in both of the key's buckets before
+	// evicting anything
+	if (table->bucket_size > 1) {
+		if (place_in_bucket(table, table->table1, h, key)
+			|| place_in_bucket(table, table->table2,
+				hash_address(h2(key), table->nbuckets), key)) {
+			return true;
+		}
+	}
 
 	int curr_inner_table = 1;
 
-	int64 temp_key, curr_key = key;
+	int64 curr_key = key;
 	int loop=0;
 
-	// make sure key is not already in table
-	if (cuckoo_hash_table_lookup(table, key)){
-		return false;
-	}
 	while (true){
 		// exits while loop if a cycle has been confirmed
 		if ((loop > table->size) && (key == curr_key)){
 			break;
 		}
 
+		// (or, in bucketized mode or while keys are being moved by a resize,
+		// when the walk isn't sure to revisit its start, once we've made too
+		// many evictions)
+		if ((table->bucket_size > 1 || table->resizing)
+			&& loop > MAX_EVICTIONS){
+			break;
+		}
+
+		// the slot to evict from a full bucket: take each slot in turn on
+		// successive visits to the same table
+		int victim = (loop / 2) % table->bucket_size;
+
 		// either insert key or swap key in table 1
 		if (curr_inner_table == 1){
-			if (table->table1->inuse[h] == false){
-				table->table1->slots[h] = key;
-				table->table1->inuse[h] = true;
+			if (place_in_bucket(table, table->table1, h, key)){
 				return true;
 			} else {
-				temp_key = table->table1->slots[h];
-				table->table1->slots[h] = key;
-				key = temp_key;
-				h = h2(key) % table->size;
+				key = evict_from_bucket(table, table->table1, h, victim, key);
+				h = hash_address(h2(key), table->nbuckets);
 				loop++;
 			}
 		}
 
 		// either insert key or swap key in table 2
 		if (curr_inner_table == 2){
-			if (table->table2->inuse[h] == false){
-				table->table2->slots[h] = key;
-				table->table2->inuse[h] = true;
+			if (place_in_bucket(table, table->table2, h, key)){
 				return true;
 			} else {
-				temp_key = table->table2->slots[h];
-				table->table2->slots[h] = key;
-				key = temp_key;
-				h = h1(key) % table->size;
+				key = evict_from_bucket(table, table->table2, h, victim, key);
+				h = hash_address(h1(key), table->nbuckets);
 				loop++;
 			}
 		}
@@ -183,29 +518,180 @@ bool cuckoo_hash_table_insert(CuckooHashTable *table, int64 key) {
 		}
 	}
 
-	// double size of table if there is a cycle
-	*table = *cuck_double_table(table);
+	// stash the key left over from the cycle, or grow the table if there
+	// is no room left in the stash
+	return stash_or_grow(table, key);
+}
+
+
+// insert 'key' into 'table', if it's not in there already
+// returns true if insertion succeeds, false if it was already in there
+bool cuckoo_hash_table_insert(CuckooHashTable *table, int64 key) {
+	assert(table != NULL);
+
+	// make sure key is not already in table
+	if (cuckoo_hash_table_lookup(table, key)){
+		return false;
+	}
+
+	// grow the table if this key would take it past its maximum load factor
+	if (table->load + 1 > table->max_load * 2 * table->size) {
+		resize_table(table, grown_size(table));
+	}
 
-	// finally insert the most recently inserted key
-	cuckoo_hash_table_insert(table, key);
+	insert_hashed(table, key, h1(key));
+	table->load++;
+	table->ninserts++;
 	return true;
 }
 
 
+// lookup whether 'key' is inside 'table', given its bucket addresses 'hash1'
+// and 'hash2' in the first and second inner tables
+// returns true if found, false if not
+static bool lookup_hashed(CuckooHashTable *table, int64 key, int hash1,
+	int hash2) {
+	// check every slot of both buckets
+	int b = table->bucket_size;
+	int64 *slots1 = &table->table1->slots[hash1 * b];
+	int64 *slots2 = &table->table2->slots[hash2 * b];
+	bool  *inuse1 = &table->table1->inuse[hash1 * b];
+	bool  *inuse2 = &table->table2->inuse[hash2 * b];
+	int i;
+	for (i = 0; i < b; i++) {
+		if ((inuse1[i] && slots1[i] == key) || (inuse2[i] && slots2[i] == key)) {
+			return true;
+		}
+	}
+
+	// any key that couldn't be placed is in the stash
+	for (i = 0; i < table->stash_load; i++) {
+		if (table->stash[i] == key) {
+			return true;
+		}
+	}
+	return false;
+}
+
+
 // lookup whether 'key' is inside 'table'
 // returns true if found, false if not
 bool cuckoo_hash_table_lookup(CuckooHashTable *table, int64 key) {
 
 	assert(table != NULL);
 
-	int hash1 = h1(key) % table->size;
-	int hash2 = h2(key) % table->size;
+	int hash1 = hash_address(h1(key), table->nbuckets);
+	int hash2 = hash_address(h2(key), table->nbuckets);
 
-	if ((table->table1->slots[hash1] == key) || (table->table2->slots[hash2] == key)){
-		return true;
+	return lookup_hashed(table, key, hash1, hash2);
+}
+
+
+// prefetch bucket 'hash1' of the first inner table and 'hash2' of the second
+// (the start of each: a bucket is at most a cache line of keys)
+static void prefetch_slots(CuckooHashTable *table, int hash1, int hash2) {
+	int b = table->bucket_size;
+	prefetch(&table->table1->slots[hash1 * b]);
+	prefetch(&table->table1->inuse[hash1 * b]);
+	prefetch(&table->table2->slots[hash2 * b]);
+	prefetch(&table->table2->inuse[hash2 * b]);
+}
+
+// prefetch both of the slots that 'key' could occupy in 'table'
+static void prefetch_key(CuckooHashTable *table, int64 key) {
+	prefetch_slots(table, hash_address(h1(key), table->nbuckets),
+		hash_address(h2(key), table->nbuckets));
+}
+
+
+// compute the addresses of the 'n' keys in 'keys' in both inner tables (into
+// 'hashes1' and 'hashes2') using the multi-key hash functions, and prefetch
+// the slots at those addresses
+static void hash_window(CuckooHashTable *table, int64 *keys, int n,
+	int *hashes1, int *hashes2) {
+	h1_multi(keys, n, hashes1);
+	h2_multi(keys, n, hashes2);
+	int i;
+	for (i = 0; i < n; i++) {
+		hashes1[i] = hash_address(hashes1[i], table->nbuckets);
+		hashes2[i] = hash_address(hashes2[i], table->nbuckets);
+		prefetch_slots(table, hashes1[i], hashes2[i]);
 	}
+}
 
-	return false;
+
+// insert the 'n' keys in 'keys' into 'table', in order, setting bit i of the
+// bitmap 'results' if keys[i] was inserted (clearing it if already there)
+// returns the number of keys inserted
+int cuckoo_hash_table_insert_batch(CuckooHashTable *table, int64 *keys, int n,
+	uint8_t *results) {
+	assert(table != NULL);
+
+	// prefetch the candidate slots of the key BATCH_WINDOW ahead of the one
+	// being inserted (evictions and doubling may still miss, but the first
+	// probe of each key should hit cache)
+	int i, ninserted = 0;
+	for (i = 0; i < n && i < BATCH_WINDOW; i++) {
+		prefetch_key(table, keys[i]);
+	}
+	for (i = 0; i < n; i++) {
+		if (i + BATCH_WINDOW < n) {
+			prefetch_key(table, keys[i + BATCH_WINDOW]);
+		}
+		bool inserted = cuckoo_hash_table_insert(table, keys[i]);
+		bitmap_set(results, i, inserted);
+		ninserted += inserted;
+	}
+
+	return ninserted;
+}
+
+
+// lookup each of the 'n' keys in 'keys', setting bit i of the bitmap
+// 'results' if keys[i] is inside 'table' (clearing it if not)
+// returns the number of keys found
+int cuckoo_hash_table_lookup_batch(CuckooHashTable *table, int64 *keys, int n,
+	uint8_t *results) {
+	assert(table != NULL);
+
+	// hash a whole window of keys at once with the multi-key hash kernels,
+	// one window ahead of the keys being probed, prefetching their slots
+	int hashes1[2][BATCH_WINDOW], hashes2[2][BATCH_WINDOW];
+	int curr = 0;
+	int start, i, nfound = 0;
+	hash_window(table, keys, n < BATCH_WINDOW ? n : BATCH_WINDOW,
+		hashes1[curr], hashes2[curr]);
+
+	for (start = 0; start < n; start += BATCH_WINDOW) {
+		int count = n - start < BATCH_WINDOW ? n - start : BATCH_WINDOW;
+
+		// hash and prefetch the next window into the other buffers
+		int next = start + BATCH_WINDOW;
+		if (next < n) {
+			int nextcount = n - next < BATCH_WINDOW ? n - next : BATCH_WINDOW;
+			hash_window(table, keys + next, nextcount,
+				hashes1[!curr], hashes2[!curr]);
+		}
+
+		// probe this window
+		for (i = 0; i < count; i++) {
+			bool found = lookup_hashed(table, keys[start + i],
+				hashes1[curr][i], hashes2[curr][i]);
+			bitmap_set(results, start + i, found);
+			nfound += found;
+		}
+		curr = !curr;
+	}
+
+	return nfound;
+}
+
+
+// the number of keys 'table' has slots for right now (in both tables, not
+// counting the stash)
+int cuckoo_hash_table_capacity(CuckooHashTable *table) {
+	assert(table != NULL);
+	return 2 * table->size;
 }
 
 
@@ -213,6 +699,10 @@ bool cuckoo_hash_table_lookup(CuckooHashTable *table, int64 key) {
 void cuckoo_hash_table_print(CuckooHashTable *table) {
 	assert(table);
 	printf("--- table size: %d\n", table->size);
+	if (table->bucket_size > 1) {
+		printf("--- (%d buckets of %d slots)\n", table->nbuckets,
+			table->bucket_size);
+	}
 
 	// print header
 	printf("                    table one         table two\n");
@@ -240,6 +730,14 @@ void cuckoo_hash_table_print(CuckooHashTable *table) {
 		}
 	}
 
+	// keys in the stash don't have an address
+	if (table->stash_size > 0) {
+		printf("--- stash (%d of %d):\n", table->stash_load, table->stash_size);
+		for (i = 0; i < table->stash_load; i++) {
+			printf(" %*llu\n", 20, table->stash[i]);
+		}
+	}
+
 	// done!
 	printf("--- end table ---\n");
 }
@@ -252,6 +750,40 @@ void cuckoo_hash_table_stats(CuckooHashTable *table) {
 
 	// print some information about the table
 	printf("current size: %d slots\n", table->size);
+	printf(" bucket size: %d slots\n", table->bucket_size);
+	printf("current load: %d items\n", table->load);
+	printf(" load factor: %.3f%%\n", table->load * 100.0 / (2 * table->size));
+	printf("     resizes: %d (%d forced by cycles)\n", table->nresizes,
+		table->nforced);
+	printf(" forced rate: %.3f per 1000 inserts\n",
+		table->ninserts ? table->nforced * 1000.0 / table->ninserts : 0);
+	printf("       stash: %d of %d keys\n", table->stash_load,
+		table->stash_size);
+	printf("stashed keys: %d\n", table->nstashed);
+	if (table->bfs_depth > 0) {
+		printf("   bfs depth: %d moves\n", table->bfs_depth);
+		printf("bfs failures: %d\n", table->bfs_failures);
+	}
+
+	// also calculate CPU time spent resizing in seconds and print this
+	float seconds = table->resize_time * 1.0 / CLOCKS_PER_SEC;
+	printf(" resize time: %.6f sec\n", seconds);
 
 	printf("--- end stats ---\n");
 }
+
+
+// fill 'stats' with statistics about 'table'
+void cuckoo_hash_table_get_stats(CuckooHashTable *table, HashStats *stats) {
+	assert(table != NULL);
+	init_hash_stats(stats);
+
+	stats->load = table->load;
+	stats->capacity = 2 * table->size;
+	stats->memory = block_bytes(table->size)
+		+ (long)table->stash_size * sizeof *table->stash
+		+ (long)table->bfs_capacity * sizeof *table->bfs_queue;
+	stats->evictions = table->nevictions;
+	stats->resizes = table->nresizes;
+	stats->resize_time = table->resize_time * 1.0 / CLOCKS_PER_SEC;
+}
@@ -11,11 +11,14 @@
 
 #include <stdbool.h>
 #include "../inthash.h"
+#include "../options.h"
+#include "../hashstats.h"
 
 typedef struct cuckoo_table CuckooHashTable;
 
-// initialise a cuckoo hash table with 'size' slots in each table
-CuckooHashTable *new_cuckoo_hash_table(int size);
+// initialise a cuckoo hash table with 'size' slots in each table, growing
+// according to the resize policy in 'options'
+CuckooHashTable *new_cuckoo_hash_table(int size, TableOptions *options);
 
 // free all memory associated with 'table'
 void free_cuckoo_hash_table(CuckooHashTable *table);
@@ -24,14 +27,33 @@ void free_cuckoo_hash_table(CuckooHashTable *table);
 // returns true if insertion succeeds, false if it was already in there
 bool cuckoo_hash_table_insert(CuckooHashTable *table, int64 key);
 
+// insert the 'n' keys in 'keys' into 'table', in order, setting bit i of the
+// bitmap 'results' if keys[i] was inserted (clearing it if already there)
+// returns the number of keys inserted
+int cuckoo_hash_table_insert_batch(CuckooHashTable *table, int64 *keys, int n,
+	uint8_t *results);
+
 // lookup whether 'key' is inside 'table'
 // returns true if found, false if not
 bool cuckoo_hash_table_lookup(CuckooHashTable *table, int64 key);
 
+// lookup each of the 'n' keys in 'keys', setting bit i of the bitmap
+// 'results' if keys[i] is inside 'table' (clearing it if not)
+// returns the number of keys found
+int cuckoo_hash_table_lookup_batch(CuckooHashTable *table, int64 *keys, int n,
+	uint8_t *results);
+
+// the number of keys 'table' has slots for right now (in both tables, not
+// counting the stash)
+int cuckoo_hash_table_capacity(CuckooHashTable *table);
+
 // print the contents of 'table' to stdout
 void cuckoo_hash_table_print(CuckooHashTable *table);
 
 // print some statistics about 'table' to stdout
 void cuckoo_hash_table_stats(CuckooHashTable *table);
 
+// fill 'stats' with statistics about 'table'
+void cuckoo_hash_table_get_stats(CuckooHashTable *table, HashStats *stats);
+
 #endif
@@ -0,0 +1,409 @@
+/* * * * * * * * *
+ * Dynamic hash table using 3-ary cuckoo hashing: each key may live in any of
+ * three tables, one per hash function, and keys are evicted from table to
+ * table to make room, so that the tables can fill much further than with two
+ * choices before an insertion fails and they have to grow
+ *
+ * created for COMP20007 Design of Algorithms - Assignment 2, 2017
+ * by Max Philip
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+
+#include "cuckoo3.h"
+#include "../batch.h"
+
+// how many tables (and so how many choices of slot) each key has: table t is
+// addressed by the hash function hk(t + 1, key)
+#define NTABLES 3
+
+// how many evictions an insertion may make before giving up and growing the
+// tables (with more than two choices, the walk isn't sure to revisit its
+// start, so there's no cycle to detect)
+#define MAX_EVICTIONS 500
+
+// seed for the random choices of the eviction walk
+#define WALK_SEED 0x2545f491
+
+
+// an inner table is a pair of parallel arrays: 'slots' for storing keys and
+// 'inuse' for marking which entries are occupied
+typedef struct inner_table {
+	int64 *slots;	// array of slots holding keys
+	bool  *inuse;	// is this slot in use or not?
+} InnerTable;
+
+// a 3-ary cuckoo hash table stores its keys in NTABLES inner tables of the
+// same size
+struct cuckoo3_table {
+	InnerTable tables[NTABLES];
+	int size;			// number of slots in each table
+	int load;			// number of keys in all tables together
+
+	double max_load;	// grow once more than this fraction of slots are full
+	double growth;		// factor to grow the tables by each time
+	int nresizes;		// how many times the tables have been resized
+	int nforced;		// how many resizes were forced by a failed insertion,
+						// rather than the load factor
+	double first_failure;	// load factor when an insertion first failed
+						// (0 if none has yet)
+	long nevictions;	// how many keys have been evicted to another table
+	uint32_t walk_state;// state of the generator choosing which table to
+						// evict from
+	long ninserts;		// how many keys have been inserted
+	long resize_time;	// how much CPU time has been spent resizing
+};
+
+
+// set up the inner tables of 'table' with new, empty arrays of 'size' slots
+static void initialise_tables(Cuckoo3HashTable *table, int size) {
+	// error message taken from linear.c file
+	assert(size < MAX_TABLE_SIZE && "error: table has grown too large!");
+
+	int t;
+	for (t = 0; t < NTABLES; t++) {
+		InnerTable *inner = &table->tables[t];
+		inner->slots = malloc((sizeof *inner->slots) * size);
+		assert(inner->slots);
+		inner->inuse = malloc((sizeof *inner->inuse) * size);
+		assert(inner->inuse);
+
+		// set all slots as not having a key
+		memset(inner->inuse, false, (sizeof *inner->inuse) * size);
+	}
+
+	table->size = size;
+}
+
+// free the arrays of the 'NTABLES' inner tables in 'tables'
+static void free_tables(InnerTable *tables) {
+	int t;
+	for (t = 0; t < NTABLES; t++) {
+		free(tables[t].slots);
+		free(tables[t].inuse);
+	}
+}
+
+
+// initialise a 3-ary cuckoo hash table with 'size' slots in each table,
+// growing according to the resize policy in 'options'
+Cuckoo3HashTable *new_cuckoo3_hash_table(int size, TableOptions *options) {
+	Cuckoo3HashTable *table = malloc(sizeof *table);
+	assert(table);
+
+	initialise_tables(table, size);
+	table->load = 0;
+
+	table->max_load = options->max_load;
+	table->growth = options->growth;
+	table->nresizes = 0;
+	table->nforced = 0;
+	table->first_failure = 0;
+	table->nevictions = 0;
+	table->walk_state = WALK_SEED;
+	table->ninserts = 0;
+	table->resize_time = 0;
+
+	return table;
+}
+
+
+// free all memory associated with 'table'
+void free_cuckoo3_hash_table(Cuckoo3HashTable *table) {
+	assert(table != NULL);
+
+	free_tables(table->tables);
+	free(table);
+}
+
+
+// a pseudo-random number from the xorshift generator of 'table'
+static uint32_t walk_random(Cuckoo3HashTable *table) {
+	uint32_t x = table->walk_state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return table->walk_state = x;
+}
+
+// put '*key' in one of its slots in 'table', evicting keys between the tables
+// as necessary
+// returns true if every key found a slot, or false if MAX_EVICTIONS evictions
+// weren't enough, in which case '*key' is set to the key left without a slot
+static bool place_key(Cuckoo3HashTable *table, int64 *key) {
+	int from = -1;	// the table the key in hand was just evicted from
+	int loop;
+	for (loop = 0; ; loop++) {
+		// put the key in the first of its slots that is free, if any is
+		int t, addresses[NTABLES];
+		for (t = 0; t < NTABLES; t++) {
+			InnerTable *inner = &table->tables[t];
+			addresses[t] = hash_address(hk(t + 1, *key), table->size);
+			if (!inner->inuse[addresses[t]]) {
+				inner->slots[addresses[t]] = *key;
+				inner->inuse[addresses[t]] = true;
+				return true;
+			}
+		}
+
+		if (loop == MAX_EVICTIONS) {
+			return false;
+		}
+
+		// otherwise evict the key from its slot in one of the tables it
+		// wasn't just evicted from (which would send it straight back),
+		// chosen at random: taking them in turn instead lets the walk fall
+		// into a cycle, and the tables fill to only ~70% (rather than ~90%)
+		// before an insertion fails. the new key wasn't evicted from
+		// anywhere, so its victim can come from any of the tables
+		if (from < 0) {
+			t = walk_random(table) % NTABLES;
+		} else {
+			t = (from + 1 + walk_random(table) % (NTABLES - 1)) % NTABLES;
+		}
+		int64 evicted = table->tables[t].slots[addresses[t]];
+		table->tables[t].slots[addresses[t]] = *key;
+		*key = evicted;
+		from = t;
+		table->nevictions++;
+	}
+}
+
+
+// the number of slots in each table to grow 'table' to next, from 'size'
+static int grown_size(Cuckoo3HashTable *table, int size) {
+	int grown = size * table->growth;
+	return grown > size ? grown : size + 1;
+}
+
+// resize the inner tables of 'table' to 'size' slots each, and re-insert all
+// keys into them (growing further if they won't all fit)
+static void resize_table(Cuckoo3HashTable *table, int size) {
+	long start_time = clock();
+
+	// keep the old arrays until every key is safely in the new ones, so
+	// that if re-inserting fails, we can start again from them at a larger
+	// size
+	InnerTable old[NTABLES];
+	memcpy(old, table->tables, sizeof old);
+	int oldsize = table->size;
+
+	bool placed = false;
+	while (!placed) {
+		initialise_tables(table, size);
+		placed = true;
+
+		int t, i;
+		for (t = 0; t < NTABLES && placed; t++) {
+			for (i = 0; i < oldsize && placed; i++) {
+				int64 key = old[t].slots[i];
+				placed = !old[t].inuse[i] || place_key(table, &key);
+			}
+		}
+
+		if (!placed) {
+			free_tables(table->tables);
+			size = grown_size(table, size);
+		}
+	}
+	free_tables(old);
+
+	table->nresizes++;
+	table->resize_time += clock() - start_time;
+}
+
+
+// lookup whether 'key' is inside 'table'
+// returns true if found, false if not
+bool cuckoo3_hash_table_lookup(Cuckoo3HashTable *table, int64 key) {
+	assert(table != NULL);
+
+	// check the key's slot in every table
+	int t;
+	for (t = 0; t < NTABLES; t++) {
+		int address = hash_address(hk(t + 1, key), table->size);
+		InnerTable *inner = &table->tables[t];
+		if (inner->inuse[address] && inner->slots[address] == key) {
+			return true;
+		}
+	}
+	return false;
+}
+
+
+// insert 'key' into 'table', if it's not in there already
+// returns true if insertion succeeds, false if it was already in there
+bool cuckoo3_hash_table_insert(Cuckoo3HashTable *table, int64 key) {
+	assert(table != NULL);
+
+	// make sure key is not already in table
+	if (cuckoo3_hash_table_lookup(table, key)) {
+		return false;
+	}
+
+	// grow the table if this key would take it past its maximum load factor
+	if (table->load + 1 > table->max_load * NTABLES * table->size) {
+		resize_table(table, grown_size(table, table->size));
+	}
+
+	// if the key (or one it evicted) can't be placed, grow the tables and
+	// place the key left over
+	while (!place_key(table, &key)) {
+		if (table->nforced == 0) {
+			table->first_failure = table->load * 1.0
+				/ (NTABLES * table->size);
+		}
+		table->nforced++;
+		resize_table(table, grown_size(table, table->size));
+	}
+
+	table->load++;
+	table->ninserts++;
+	return true;
+}
+
+
+// prefetch every slot that 'key' could occupy in 'table'
+static void prefetch_key(Cuckoo3HashTable *table, int64 key) {
+	int t;
+	for (t = 0; t < NTABLES; t++) {
+		int address = hash_address(hk(t + 1, key), table->size);
+		prefetch(&table->tables[t].slots[address]);
+		prefetch(&table->tables[t].inuse[address]);
+	}
+}
+
+
+// insert the 'n' keys in 'keys' into 'table', in order, setting bit i of the
+// bitmap 'results' if keys[i] was inserted (clearing it if already there)
+// returns the number of keys inserted
+int cuckoo3_hash_table_insert_batch(Cuckoo3HashTable *table, int64 *keys,
+	int n, uint8_t *results) {
+	assert(table != NULL);
+
+	// prefetch the candidate slots of the key BATCH_WINDOW ahead of the one
+	// being inserted (evictions and growing may still miss, but the first
+	// probe of each key should hit cache)
+	int i, ninserted = 0;
+	for (i = 0; i < n && i < BATCH_WINDOW; i++) {
+		prefetch_key(table, keys[i]);
+	}
+	for (i = 0; i < n; i++) {
+		if (i + BATCH_WINDOW < n) {
+			prefetch_key(table, keys[i + BATCH_WINDOW]);
+		}
+		bool inserted = cuckoo3_hash_table_insert(table, keys[i]);
+		bitmap_set(results, i, inserted);
+		ninserted += inserted;
+	}
+
+	return ninserted;
+}
+
+
+// lookup each of the 'n' keys in 'keys', setting bit i of the bitmap
+// 'results' if keys[i] is inside 'table' (clearing it if not)
+// returns the number of keys found
+int cuckoo3_hash_table_lookup_batch(Cuckoo3HashTable *table, int64 *keys,
+	int n, uint8_t *results) {
+	assert(table != NULL);
+
+	// prefetch the candidate slots of the key BATCH_WINDOW ahead of the one
+	// being looked up
+	int i, nfound = 0;
+	for (i = 0; i < n && i < BATCH_WINDOW; i++) {
+		prefetch_key(table, keys[i]);
+	}
+	for (i = 0; i < n; i++) {
+		if (i + BATCH_WINDOW < n) {
+			prefetch_key(table, keys[i + BATCH_WINDOW]);
+		}
+		bool found = cuckoo3_hash_table_lookup(table, keys[i]);
+		bitmap_set(results, i, found);
+		nfound += found;
+	}
+
+	return nfound;
+}
+
+
+// the number of keys 'table' has slots for right now (in all three tables)
+int cuckoo3_hash_table_capacity(Cuckoo3HashTable *table) {
+	assert(table != NULL);
+	return NTABLES * table->size;
+}
+
+
+// print the contents of 'table' to stdout
+void cuckoo3_hash_table_print(Cuckoo3HashTable *table) {
+	assert(table);
+	printf("--- table size: %d\n", table->size);
+
+	// print header
+	printf("   address |            table one            table two"
+		"          table three\n");
+
+	// print rows of all tables
+	int i, t;
+	for (i = 0; i < table->size; i++) {
+		printf(" %*d |", 9, i);
+		for (t = 0; t < NTABLES; t++) {
+			if (table->tables[t].inuse[i]) {
+				printf(" %*llu", 20, table->tables[t].slots[i]);
+			} else {
+				printf(" %*s", 20, "-");
+			}
+		}
+		printf("\n");
+	}
+
+	// done!
+	printf("--- end table ---\n");
+}
+
+
+// print some statistics about 'table' to stdout
+void cuckoo3_hash_table_stats(Cuckoo3HashTable *table) {
+	assert(table != NULL);
+	printf("--- table stats ---\n");
+
+	// print some information about the table
+	printf("current size: %d slots (in each of %d tables)\n", table->size,
+		NTABLES);
+	printf("current load: %d items\n", table->load);
+	printf(" load factor: %.3f%%\n",
+		table->load * 100.0 / (NTABLES * table->size));
+	printf("   evictions: %ld (%.3f per insert)\n", table->nevictions,
+		table->ninserts ? table->nevictions * 1.0 / table->ninserts : 0);
+	printf("     resizes: %d (%d forced by failed insertions)\n",
+		table->nresizes, table->nforced);
+	if (table->nforced > 0) {
+		printf("first failed: at load factor %.3f%%\n",
+			table->first_failure * 100);
+	}
+
+	// also calculate CPU time spent resizing in seconds and print this
+	float seconds = table->resize_time * 1.0 / CLOCKS_PER_SEC;
+	printf(" resize time: %.6f sec\n", seconds);
+
+	printf("--- end stats ---\n");
+}
+
+
+// fill 'stats' with statistics about 'table'
+void cuckoo3_hash_table_get_stats(Cuckoo3HashTable *table, HashStats *stats) {
+	assert(table != NULL);
+	init_hash_stats(stats);
+
+	stats->load = table->load;
+	stats->capacity = NTABLES * table->size;
+	stats->memory = (long)NTABLES * table->size
+		* (sizeof *table->tables[0].slots + sizeof *table->tables[0].inuse);
+	stats->evictions = table->nevictions;
+	stats->resizes = table->nresizes;
+	stats->resize_time = table->resize_time * 1.0 / CLOCKS_PER_SEC;
+}
@@ -0,0 +1,60 @@
+/* * * * * * * * *
+ * Dynamic hash table using 3-ary cuckoo hashing: each key may live in any of
+ * three tables, one per hash function, and keys are evicted from table to
+ * table to make room, so that the tables can fill much further than with two
+ * choices before an insertion fails and they have to grow
+ *
+ * created for COMP20007 Design of Algorithms - Assignment 2, 2017
+ * by Max Philip
+ */
+
+#ifndef CUCKOO3_H
+#define CUCKOO3_H
+
+#include <stdbool.h>
+#include "../inthash.h"
+#include "../options.h"
+#include "../hashstats.h"
+
+typedef struct cuckoo3_table Cuckoo3HashTable;
+
+// initialise a 3-ary cuckoo hash table with 'size' slots in each table,
+// growing according to the resize policy in 'options'
+Cuckoo3HashTable *new_cuckoo3_hash_table(int size, TableOptions *options);
+
+// free all memory associated with 'table'
+void free_cuckoo3_hash_table(Cuckoo3HashTable *table);
+
+// insert 'key' into 'table', if it's not in there already
+// returns true if insertion succeeds, false if it was already in there
+bool cuckoo3_hash_table_insert(Cuckoo3HashTable *table, int64 key);
+
+// insert the 'n' keys in 'keys' into 'table', in order, setting bit i of the
+// bitmap 'results' if keys[i] was inserted (clearing it if already there)
+// returns the number of keys inserted
+int cuckoo3_hash_table_insert_batch(Cuckoo3HashTable *table, int64 *keys, int n,
+	uint8_t *results);
+
+// lookup whether 'key' is inside 'table'
+// returns true if found, false if not
+bool cuckoo3_hash_table_lookup(Cuckoo3HashTable *table, int64 key);
+
+// lookup each of the 'n' keys in 'keys', setting bit i of the bitmap
+// 'results' if keys[i] is inside 'table' (clearing it if not)
+// returns the number of keys found
+int cuckoo3_hash_table_lookup_batch(Cuckoo3HashTable *table, int64 *keys, int n,
+	uint8_t *results);
+
+// the number of keys 'table' has slots for right now (in all three tables)
+int cuckoo3_hash_table_capacity(Cuckoo3HashTable *table);
+
+// print the contents of 'table' to stdout
+void cuckoo3_hash_table_print(Cuckoo3HashTable *table);
+
+// print some statistics about 'table' to stdout
+void cuckoo3_hash_table_stats(Cuckoo3HashTable *table);
+
+// fill 'stats' with statistics about 'table'
+void cuckoo3_hash_table_get_stats(Cuckoo3HashTable *table, HashStats *stats);
+
+#endif
@@ -8,24 +8,61 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <time.h>
 
 #include "linear.h"
+#include "../batch.h"
 
 // how many cells to advance at a time while looking for a free slot
 #define STEP_SIZE 1
 
+// in the sentinel layout, free slots hold this reserved key
+#define EMPTY_KEY 0x9e3779b97f4a7c15ULL
+
 // a hash table is an array of slots holding keys, along with a parallel array
 // of boolean markers recording which slots are in use (true) or free (false)
 // important because not-in-use slots might hold garbage data, as they may
 // not have been initialised
+//
+// alternatively, in the sentinel layout, there is no 'inuse' array: free slots
+// are marked by holding EMPTY_KEY, so that probing only touches one array. if
+// EMPTY_KEY itself is inserted, it is recorded by a flag instead of a slot
+//
+// in robin hood mode, a third parallel array records each key's displacement
+// from its home address, which lets unsuccessful lookups stop early
+//
+// in incremental mode, growing the table doesn't rehash every key at once:
+// the old arrays are kept (as a table of their own) alongside the new ones,
+// and every insert and lookup moves a bounded number of old slots across
+// until none are left, so no single operation pays for the whole resize
 struct linear_table {
 	int64 *slots;	// array of slots holding keys
-	bool  *inuse;	// is this slot in use or not?
+	bool  *inuse;	// is this slot in use or not? (NULL in sentinel layout)
 	int size;		// the size of both of these arrays right now
 	int load;		// number of keys in the table right now
 	int collisions;
 	int lin_probes;
 
+	bool sentinel;			// are we using the sentinel layout?
+	bool empty_key_inuse;	// sentinel layout: is EMPTY_KEY in the table?
+
+	bool robin_hood;		// are we using robin hood insertion?
+	int *dists;				// robin hood: displacement of the key in each slot
+	int max_dist;			// robin hood: largest displacement of any key
+
+	double max_load;		// grow once more than this fraction of slots is full
+	double growth;			// factor to grow the arrays by each time
+	int nresizes;			// how many times the arrays have been resized
+	long resize_time;		// how much CPU time has been spent resizing
+
+	int migrate;			// incremental: old slots to move per operation
+							// (0 for stop-the-world resizing)
+	int migrate_step;		// incremental: old slots to move per operation
+							// during the current migration (at least migrate)
+	LinearHashTable *old;	// incremental: old arrays still being migrated
+							// from (NULL when not resizing)
+	int migrated;			// incremental: how many old slots have been moved
+	bool migrating;			// incremental: are we moving keys right now?
 };
 
 
@@ -33,6 +70,43 @@ struct linear_table {
  * helper functions
  */
 
+// advance address 'h' by STEP_SIZE, wrapping around to the start of a table of
+// size 'size' by subtraction rather than a modulo
+static int step(int h, int size) {
+	h += STEP_SIZE;
+	while (h >= size) {
+		h -= size;
+	}
+	return h;
+}
+
+// is the slot at address 'h' holding a key?
+static bool slot_inuse(LinearHashTable *table, int h) {
+	if (table->sentinel) {
+		return table->slots[h] != EMPTY_KEY;
+	}
+	return table->inuse[h];
+}
+
+// store 'key' in the free slot at address 'h'
+static void fill_slot(LinearHashTable *table, int h, int64 key) {
+	table->slots[h] = key;
+	if (!table->sentinel) {
+		table->inuse[h] = true;
+	}
+}
+
+// prefetch the memory needed to probe the slot at address 'h'
+static void prefetch_slot(LinearHashTable *table, int h) {
+	prefetch(&table->slots[h]);
+	if (!table->sentinel) {
+		prefetch(&table->inuse[h]);
+	}
+	if (table->robin_hood) {
+		prefetch(&table->dists[h]);
+	}
+}
+
 // set up the internals of a linear hash table struct with new
 // arrays of size 'size'
 static void initialise_table(LinearHashTable *table, int size) {
@@ -40,12 +114,28 @@ static void initialise_table(LinearHashTable *table, int size) {
 
 	table->slots = malloc((sizeof *table->slots) * size);
 	assert(table->slots);
-	table->inuse = malloc((sizeof *table->inuse) * size);
-	assert(table->inuse);
 	int i;
-	for (i = 0; i < size; i++) {
-		table->inuse[i] = false;
+	if (table->sentinel) {
+		// no separate array of markers; mark free slots with EMPTY_KEY
+		table->inuse = NULL;
+		for (i = 0; i < size; i++) {
+			table->slots[i] = EMPTY_KEY;
+		}
+	} else {
+		table->inuse = malloc((sizeof *table->inuse) * size);
+		assert(table->inuse);
+		for (i = 0; i < size; i++) {
+			table->inuse[i] = false;
+		}
+	}
+
+	// displacements are only meaningful for slots in use, so need no setup
+	table->dists = NULL;
+	if (table->robin_hood) {
+		table->dists = malloc((sizeof *table->dists) * size);
+		assert(table->dists);
 	}
+	table->max_dist = 0;
 
 	table->size = size;
 	table->load = 0;
@@ -55,85 +145,256 @@ static void initialise_table(LinearHashTable *table, int size) {
 }
 
 
-// double the size of the internal table arrays and re-hash all
-// keys in the old tables
-static void double_table(LinearHashTable *table) {
-	int64 *oldslots = table->slots;
-	bool  *oldinuse = table->inuse;
-	int oldsize = table->size;
+static bool insert_hashed(LinearHashTable *table, int64 key, int hash);
+static bool lookup_from(LinearHashTable *table, int64 key, int h);
 
-	initialise_table(table, table->size * 2);
+// incremental mode: move the keys from the next 'n' slots of the old arrays
+// into the new arrays, and free the old arrays once they have all been moved
+static void migrate_slots(LinearHashTable *table, int n) {
+	LinearHashTable *old = table->old;
+	if (old == NULL) {
+		return;
+	}
+	long start_time = clock();
+
+	int end = table->migrated + n;
+	if (end > old->size) {
+		end = old->size;
+	}
 
+	// these keys are already counted in the load, and the new arrays were
+	// sized to take them, so they shouldn't trigger another resize
+	table->migrating = true;
 	int i;
+	for (i = table->migrated; i < end; i++) {
+		if (slot_inuse(old, i)) {
+			table->load--;
+			insert_hashed(table, old->slots[i], h1(old->slots[i]));
+		}
+	}
+	table->migrating = false;
+	table->migrated = end;
+
+	if (table->migrated == old->size) {
+		table->old = NULL;
+		free_linear_hash_table(old);
+	}
+
+	table->resize_time += clock() - start_time;
+}
+
+// incremental mode: start moving keys from the current arrays into new arrays
+// of 'size' slots
+static void start_migration(LinearHashTable *table, int size) {
+	long start_time = clock();
+
+	// the current arrays become a table of their own, for lookups to check
+	// until all of its keys have been moved
+	LinearHashTable *old = malloc(sizeof *old);
+	assert(old);
+	*old = *table;
+	old->old = NULL;
+
+	int oldload = table->load;
+	initialise_table(table, size);
+	table->load = oldload;
+	table->old = old;
+	table->migrated = 0;
+
+	// move slots fast enough that the migration finishes before new inserts
+	// can fill the new arrays up to their maximum load factor
+	int headroom = table->max_load * size - oldload;
+	table->migrate_step = table->migrate;
+	if (headroom <= 0) {
+		table->migrate_step = old->size;
+	} else if ((old->size + headroom - 1) / headroom > table->migrate_step) {
+		table->migrate_step = (old->size + headroom - 1) / headroom;
+	}
+
+	table->nresizes++;
+	table->resize_time += clock() - start_time;
+}
+
+// incremental mode: is 'key', which hashes to 'hash', in the old arrays?
+static bool in_old_table(LinearHashTable *table, int64 key, int hash) {
+	LinearHashTable *old = table->old;
+	return old && lookup_from(old, key, hash_address(hash, old->size));
+}
+
+// resize the internal table arrays to 'size' slots and re-hash all
+// keys in the old arrays
+static void resize_table(LinearHashTable *table, int size) {
+	if (table->migrate) {
+		// can't keep two generations of old arrays around: finish off any
+		// migration already underway before starting the next one
+		if (table->old) {
+			migrate_slots(table, table->old->size);
+		}
+		start_migration(table, size);
+		return;
+	}
+
+	long start_time = clock();
+
+	int64 *oldslots = table->slots;
+	bool  *oldinuse = table->inuse;
+	int   *olddists = table->dists;
+	int oldsize = table->size;
+	int oldload = table->load;
+
+	// gather the old keys together so they can all be hashed at once
+	int64 *keys = malloc((sizeof *keys) * oldsize);
+	assert(keys);
+	int *hashes = malloc((sizeof *hashes) * oldsize);
+	assert(hashes);
+	int i, nkeys = 0;
 	for (i = 0; i < oldsize; i++) {
-		if (oldinuse[i] == true) {
-			linear_hash_table_insert(table, oldslots[i]);
+		if (slot_inuse(table, i)) {
+			keys[nkeys++] = oldslots[i];
 		}
 	}
+	h1_multi(keys, nkeys, hashes);
+
+	initialise_table(table, size);
+
+	for (i = 0; i < nkeys; i++) {
+		insert_hashed(table, keys[i], hashes[i]);
+	}
+	// (this also counts a key held by the sentinel layout's flag)
+	table->load = oldload;
 
+	free(keys);
+	free(hashes);
 	free(oldslots);
 	free(oldinuse);
+	free(olddists);
+
+	table->nresizes++;
+	table->resize_time += clock() - start_time;
 }
 
 
-/* * * *
- * all functions
- */
-
-// initialise a linear probing hash table with initial size 'size'
-LinearHashTable *new_linear_hash_table(int size) {
-	LinearHashTable *table = malloc(sizeof *table);
-	assert(table);
+// the size to grow the arrays of 'table' to next
+static int grown_size(LinearHashTable *table) {
+	int size = table->size * table->growth;
+	return size > table->size ? size : table->size + 1;
+}
 
-	// set up the internals of the table struct with arrays of size 'size'
-	initialise_table(table, size);
 
-	return table;
+// would adding one more key take 'table' past its maximum load factor?
+// (never true for keys being migrated, which the arrays were sized to hold)
+static bool over_max_load(LinearHashTable *table) {
+	return !table->migrating
+		&& table->load + 1 > table->max_load * table->size;
 }
 
 
-// free all memory associated with 'table'
-void free_linear_hash_table(LinearHashTable *table) {
-	assert(table != NULL);
+// insert 'key', which hashes to 'hash', using robin hood probing: the key
+// being inserted takes the slot of any resident key that is closer to its own
+// home address than the inserted key is, and the displaced key carries on
+// probing in its place. this keeps displacements even, and means a lookup can
+// stop as soon as it passes a key closer to home than it would be
+// returns true if insertion succeeds, false if it was already in there
+static bool robin_hood_insert(LinearHashTable *table, int64 key, int hash) {
 
-	// free the table's arrays
-	free(table->slots);
-	free(table->inuse);
+	int h = hash_address(hash, table->size);
+	int dist = 0;
 
-	// free the table struct itself
-	free(table);
+	// FIRST, look for the key itself: it can't be stored beyond the first slot
+	// whose key is closer to home than the key would be
+	while (slot_inuse(table, h) && table->dists[h] >= dist) {
+		if (table->slots[h] == key) {
+			// this key already exists in the table! no need to insert
+			return false;
+		}
+		h = step(h, table->size);
+		dist++;
+	}
+
+	// the key isn't there. if there's no room for it (including the case of a
+	// full table, which has no free slot to end a chain of displacements) then
+	// grow the table and start again
+	if (over_max_load(table)) {
+		resize_table(table, grown_size(table));
+		return robin_hood_insert(table, key, hash);
+	}
+
+	if (dist > 0) {
+		table->collisions++;
+	}
+	table->lin_probes += dist;
+	table->load++;
+
+	// THEN, place it, displacing residents closer to home until we reach a
+	// free slot (there must be one, since the table wasn't full)
+	while (slot_inuse(table, h)) {
+		if (table->dists[h] < dist) {
+			int64 displaced_key = table->slots[h];
+			int displaced_dist = table->dists[h];
+			table->slots[h] = key;
+			table->dists[h] = dist;
+			if (dist > table->max_dist) {
+				table->max_dist = dist;
+			}
+			key = displaced_key;
+			dist = displaced_dist;
+		}
+		h = step(h, table->size);
+		dist++;
+	}
+
+	fill_slot(table, h, key);
+	table->dists[h] = dist;
+	if (dist > table->max_dist) {
+		table->max_dist = dist;
+	}
+	return true;
 }
 
 
-// insert 'key' into 'table', if it's not in there already
+// insert 'key' into 'table' given its (unreduced) hash value 'hash'
 // returns true if insertion succeeds, false if it was already in there
-bool linear_hash_table_insert(LinearHashTable *table, int64 key) {
-	assert(table != NULL);
+static bool insert_hashed(LinearHashTable *table, int64 key, int hash) {
+
+	// in the sentinel layout, the reserved key is stored by a flag
+	if (table->sentinel && key == EMPTY_KEY) {
+		if (table->empty_key_inuse) {
+			return false;
+		}
+		table->empty_key_inuse = true;
+		table->load++;
+		return true;
+	}
+
+	if (table->robin_hood) {
+		return robin_hood_insert(table, key, hash);
+	}
 
 	// need to count our steps to make sure we recognise when the table is full
 	int steps = 0;
 
 	// calculate the initial address for this key
-	int h = h1(key) % table->size;
+	int h = hash_address(hash, table->size);
 
-	// step along the array until we find a free space (inuse[]==false),
-	// or until we visit every cell
-	while (table->inuse[h] && steps < table->size) {
+	// step along the array until we find a free space, or until we visit
+	// every cell
+	while (slot_inuse(table, h) && steps < table->size) {
 		if (table->slots[h] == key) {
 			// this key already exists in the table! no need to insert
 			return false;
 		}
 		// else, keep stepping through the table looking for a free slot
-		h = (h + STEP_SIZE) % table->size;
+		h = step(h, table->size);
 		steps++;
 	}
 
 	// if we used up all of our steps, then we're back where we started and the
 	// table is full
-	if (steps == table->size) {
+	// (or, if the key would take the table past its maximum load factor)
+	if (steps == table->size || over_max_load(table)) {
 		// let's make some more space and then try to insert this key again!
-		double_table(table);
-		return linear_hash_table_insert(table, key);
+		resize_table(table, grown_size(table));
+		return insert_hashed(table, key, hash);
 
 	} else {
 
@@ -144,28 +405,42 @@ bool linear_hash_table_insert(LinearHashTable *table, int64 key) {
 
 
 		// otherwise, we have found a free slot! insert this key right here
-		table->slots[h] = key;
-		table->inuse[h] = true;
+		fill_slot(table, h, key);
 		table->load++;
 		return true;
 	}
 }
 
 
-// lookup whether 'key' is inside 'table'
+// lookup whether 'key' is inside 'table', starting from address 'h'
 // returns true if found, false if not
-bool linear_hash_table_lookup(LinearHashTable *table, int64 key) {
-	assert(table != NULL);
+static bool lookup_from(LinearHashTable *table, int64 key, int h) {
+
+	// in the sentinel layout, the reserved key is stored by a flag
+	if (table->sentinel && key == EMPTY_KEY) {
+		return table->empty_key_inuse;
+	}
+
+	// in robin hood mode, stop as soon as we pass a key that is closer to its
+	// home address than this key would be, or have gone further than any key
+	if (table->robin_hood) {
+		int dist = 0;
+		while (slot_inuse(table, h) && dist <= table->dists[h]
+				&& dist <= table->max_dist) {
+			if (table->slots[h] == key) {
+				return true;
+			}
+			h = step(h, table->size);
+			dist++;
+		}
+		return false;
+	}
 
 	// need to count our steps to make sure we recognise when the table is full
 	int steps = 0;
 
-	// calculate the initial address for this key
-	int h = h1(key) % table->size;
-
-	// step along until we find a free space (inuse[]==false), or until we
-	// visit every cell
-	while (table->inuse[h] && steps < table->size) {
+	// step along until we find a free space, or until we visit every cell
+	while (slot_inuse(table, h) && steps < table->size) {
 
 		if (table->slots[h] == key) {
 			// found the key!
@@ -173,7 +448,7 @@ bool linear_hash_table_lookup(LinearHashTable *table, int64 key) {
 		}
 
 		// keep stepping
-		h = (h + STEP_SIZE) % table->size;
+		h = step(h, table->size);
 		steps++;
 	}
 
@@ -183,6 +458,169 @@ bool linear_hash_table_lookup(LinearHashTable *table, int64 key) {
 }
 
 
+// insert 'key', which hashes to 'hash', into 'table' as a single operation,
+// first doing this operation's share of any incremental migration
+// returns true if insertion succeeds, false if it was already in there
+static bool insert_key(LinearHashTable *table, int64 key, int hash) {
+	migrate_slots(table, table->migrate_step);
+	if (in_old_table(table, key, hash)) {
+		return false;
+	}
+	return insert_hashed(table, key, hash);
+}
+
+
+// lookup whether 'key', which hashes to 'hash', is inside 'table' as a single
+// operation, first doing this operation's share of any incremental migration
+// returns true if found, false if not
+static bool lookup_key(LinearHashTable *table, int64 key, int hash) {
+	migrate_slots(table, table->migrate_step);
+	return lookup_from(table, key, hash_address(hash, table->size))
+		|| in_old_table(table, key, hash);
+}
+
+
+/* * * *
+ * all functions
+ */
+
+// initialise a linear probing hash table with initial size 'size', using the
+// slot layout chosen by 'options->sentinel'
+LinearHashTable *new_linear_hash_table(int size, TableOptions *options) {
+	LinearHashTable *table = malloc(sizeof *table);
+	assert(table);
+
+	table->sentinel = options->sentinel;
+	table->empty_key_inuse = false;
+	table->robin_hood = options->robin_hood;
+	table->max_load = options->max_load;
+	table->growth = options->growth;
+	table->nresizes = 0;
+	table->resize_time = 0;
+	table->migrate = options->migrate;
+	table->migrate_step = 0;
+	table->old = NULL;
+	table->migrated = 0;
+	table->migrating = false;
+
+	// set up the internals of the table struct with arrays of size 'size'
+	initialise_table(table, size);
+
+	return table;
+}
+
+
+// free all memory associated with 'table'
+void free_linear_hash_table(LinearHashTable *table) {
+	assert(table != NULL);
+
+	// free the table's arrays
+	free(table->slots);
+	free(table->inuse);
+	free(table->dists);
+	if (table->old) {
+		free_linear_hash_table(table->old);
+	}
+
+	// free the table struct itself
+	free(table);
+}
+
+
+// insert 'key' into 'table', if it's not in there already
+// returns true if insertion succeeds, false if it was already in there
+bool linear_hash_table_insert(LinearHashTable *table, int64 key) {
+	assert(table != NULL);
+
+	return insert_key(table, key, h1(key));
+}
+
+
+// insert the 'n' keys in 'keys' into 'table', in order, setting bit i of the
+// bitmap 'results' if keys[i] was inserted (clearing it if already there)
+// returns the number of keys inserted
+int linear_hash_table_insert_batch(LinearHashTable *table, int64 *keys, int n,
+	uint8_t *results) {
+	assert(table != NULL);
+
+	// hash keys BATCH_WINDOW ahead of the one being inserted, and prefetch
+	// the slots they will start probing from
+	int hashes[BATCH_WINDOW];
+	int i, ninserted = 0;
+	for (i = 0; i < n && i < BATCH_WINDOW; i++) {
+		hashes[i] = h1(keys[i]);
+		prefetch_slot(table, hash_address(hashes[i], table->size));
+	}
+
+	for (i = 0; i < n; i++) {
+		int hash = hashes[i % BATCH_WINDOW];
+
+		// refill this window entry with the key BATCH_WINDOW ahead
+		// (if the table doubles in the meantime, the prefetch is just wasted)
+		if (i + BATCH_WINDOW < n) {
+			int next = h1(keys[i + BATCH_WINDOW]);
+			hashes[i % BATCH_WINDOW] = next;
+			prefetch_slot(table, hash_address(next, table->size));
+		}
+
+		bool inserted = insert_key(table, keys[i], hash);
+		bitmap_set(results, i, inserted);
+		ninserted += inserted;
+	}
+
+	return ninserted;
+}
+
+
+// lookup whether 'key' is inside 'table'
+// returns true if found, false if not
+bool linear_hash_table_lookup(LinearHashTable *table, int64 key) {
+	assert(table != NULL);
+
+	return lookup_key(table, key, h1(key));
+}
+
+
+// lookup each of the 'n' keys in 'keys', setting bit i of the bitmap
+// 'results' if keys[i] is inside 'table' (clearing it if not)
+// returns the number of keys found
+int linear_hash_table_lookup_batch(LinearHashTable *table, int64 *keys, int n,
+	uint8_t *results) {
+	assert(table != NULL);
+
+	// pipeline: hash and prefetch BATCH_WINDOW keys ahead of the one probed
+	int hashes[BATCH_WINDOW];
+	int i, nfound = 0;
+	for (i = 0; i < n && i < BATCH_WINDOW; i++) {
+		hashes[i] = h1(keys[i]);
+		prefetch_slot(table, hash_address(hashes[i], table->size));
+	}
+
+	for (i = 0; i < n; i++) {
+		int hash = hashes[i % BATCH_WINDOW];
+
+		if (i + BATCH_WINDOW < n) {
+			int next = h1(keys[i + BATCH_WINDOW]);
+			hashes[i % BATCH_WINDOW] = next;
+			prefetch_slot(table, hash_address(next, table->size));
+		}
+
+		bool found = lookup_key(table, keys[i], hash);
+		bitmap_set(results, i, found);
+		nfound += found;
+	}
+
+	return nfound;
+}
+
+
+// the number of keys 'table' has slots for right now
+int linear_hash_table_capacity(LinearHashTable *table) {
+	assert(table != NULL);
+	return table->size;
+}
+
+
 // print the contents of 'table' to stdout
 void linear_hash_table_print(LinearHashTable *table) {
 	assert(table != NULL);
@@ -200,13 +638,29 @@ void linear_hash_table_print(LinearHashTable *table) {
 		printf(" %*d | ", 9, i);
 
 		// print the contents of the slot
-		if (table->inuse[i]) {
+		if (slot_inuse(table, i)) {
 			printf("%llu\n", table->slots[i]);
 		} else {
 			printf("-\n");
 		}
 	}
 
+	// the sentinel layout's reserved key doesn't live in any slot
+	if (table->sentinel && table->empty_key_inuse) {
+		printf("      flag | %llu\n", EMPTY_KEY);
+	}
+
+	// keys not yet moved out of the old arrays are still in the table too
+	if (table->old) {
+		printf("--- old table size: %d (slots not yet moved)\n",
+			table->old->size);
+		for (i = table->migrated; i < table->old->size; i++) {
+			if (slot_inuse(table->old, i)) {
+				printf(" %*d | %llu\n", 9, i, table->old->slots[i]);
+			}
+		}
+	}
+
 	printf("--- end table ---\n");
 }
 
@@ -221,8 +675,52 @@ void linear_hash_table_stats(LinearHashTable *table) {
 	printf("current load: %d items\n", table->load);
 	printf(" load factor: %.3f%%\n", table->load * 100.0 / table->size);
 	printf("   step size: %d slots\n", STEP_SIZE);
+	printf(" slot layout: %s\n", table->sentinel ? "sentinel" : "inuse array");
+	if (table->robin_hood) {
+		printf("    max disp: %d slots\n", table->max_dist);
+	}
+	printf("     resizes: %d\n", table->nresizes);
+	if (table->migrate) {
+		printf("   migration: %d slots/op", table->migrate_step);
+		if (table->old) {
+			printf(", %d of %d old slots moved", table->migrated,
+				table->old->size);
+		}
+		printf("\n");
+	}
+
+	// also calculate CPU time spent resizing in seconds and print this
+	float seconds = table->resize_time * 1.0 / CLOCKS_PER_SEC;
+	printf(" resize time: %.6f sec\n", seconds);
 	printf("  collisions: %d \n", table->collisions);
 	printf("  lin probes: %f \n", (table->lin_probes*1.0) / table->collisions*1.0);
 
 	printf("--- end stats ---\n");
 }
+
+
+// the number of bytes held by the arrays of 'table' (and of any old arrays
+// it is still migrating keys from)
+static long table_bytes(LinearHashTable *table) {
+	long slot_bytes = sizeof *table->slots;
+	if (!table->sentinel) {
+		slot_bytes += sizeof *table->inuse;
+	}
+	if (table->robin_hood) {
+		slot_bytes += sizeof *table->dists;
+	}
+	return slot_bytes * table->size + (table->old ? table_bytes(table->old) : 0);
+}
+
+// fill 'stats' with statistics about 'table'
+void linear_hash_table_get_stats(LinearHashTable *table, HashStats *stats) {
+	assert(table != NULL);
+	init_hash_stats(stats);
+
+	stats->load = table->load;
+	stats->capacity = table->size;
+	stats->memory = table_bytes(table);
+	stats->probes = table->lin_probes;
+	stats->resizes = table->nresizes;
+	stats->resize_time = table->resize_time * 1.0 / CLOCKS_PER_SEC;
+}
@@ -7,11 +7,16 @@
 
 #include <stdbool.h>
 #include "../inthash.h"
+#include "../options.h"
+#include "../hashstats.h"
 
 typedef struct linear_table LinearHashTable;
 
-// initialise a linear probing hash table with initial size 'size'
-LinearHashTable *new_linear_hash_table(int size);
+// initialise a linear probing hash table with initial size 'size', using the
+// slot layout chosen by 'options->sentinel', robin hood insertion if
+// 'options->robin_hood' is set, and the resize policy in 'options' (resizing
+// incrementally if 'options->migrate' is nonzero)
+LinearHashTable *new_linear_hash_table(int size, TableOptions *options);
 
 // free all memory associated with 'table'
 void free_linear_hash_table(LinearHashTable *table);
@@ -20,13 +25,31 @@ void free_linear_hash_table(LinearHashTable *table);
 // returns true if insertion succeeds, false if it was already in there
 bool linear_hash_table_insert(LinearHashTable *table, int64 key);
 
+// insert the 'n' keys in 'keys' into 'table', in order, setting bit i of the
+// bitmap 'results' if keys[i] was inserted (clearing it if already there)
+// returns the number of keys inserted
+int linear_hash_table_insert_batch(LinearHashTable *table, int64 *keys, int n,
+	uint8_t *results);
+
 // lookup whether 'key' is inside 'table'
 // returns true if found, false if not
 bool linear_hash_table_lookup(LinearHashTable *table, int64 key);
 
+// lookup each of the 'n' keys in 'keys', setting bit i of the bitmap
+// 'results' if keys[i] is inside 'table' (clearing it if not)
+// returns the number of keys found
+int linear_hash_table_lookup_batch(LinearHashTable *table, int64 *keys, int n,
+	uint8_t *results);
+
+// the number of keys 'table' has slots for right now
+int linear_hash_table_capacity(LinearHashTable *table);
+
 // print the contents of 'table' to stdout
 void linear_hash_table_print(LinearHashTable *table);
 
 // print some statistics about 'table' to stdout
 void linear_hash_table_stats(LinearHashTable *table);
 
+// fill 'stats' with statistics about 'table'
+void linear_hash_table_get_stats(LinearHashTable *table, HashStats *stats);
+
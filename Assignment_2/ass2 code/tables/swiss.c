@@ -0,0 +1,461 @@
+/* * * * * * * * *
+ * Dynamic hash table in the style of a SwissTable: open addressing over
+ * groups of 16 slots, with a parallel array of 1-byte control tags that lets
+ * a whole group be searched with a couple of vector instructions
+ *
+ * created for COMP20007 Design of Algorithms - Assignment 2, 2017
+ * by Max Philip
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <time.h>
+
+#include "swiss.h"
+#include "../batch.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// how many slots make up a group (one 16-byte vector of control bytes)
+#define GROUP_WIDTH 16
+
+// control byte for a slot without a key (which ends a search). it has the
+// high bit set, so it can never equal a tag, which is only 7 bits
+#define CTRL_EMPTY   ((uint8_t)0x80)
+
+// searches only stop at a group with an empty slot, so the table must never
+// be allowed to fill up completely
+#define MAX_MAX_LOAD 0.875
+
+// a swiss table is an array of slots holding keys, divided into groups of
+// GROUP_WIDTH slots, along with a parallel array of control bytes. the control
+// byte of a slot in use holds a 7-bit tag taken from the key's hash, so a
+// search only needs to compare the keys whose tags match (1 in 128 of the
+// others, on average)
+//
+// a key's hash picks a home group, and the search goes group by group from
+// there (wrapping around) until it finds the key or a group with an empty slot
+struct swiss_table {
+	uint8_t *ctrl;	// control byte for each slot: a tag, or EMPTY
+	int64 *slots;	// array of slots holding keys
+	int ngroups;	// number of groups of slots
+	int size;		// number of slots (ngroups * GROUP_WIDTH)
+	int load;		// number of keys in the table right now
+
+	long searches;	// how many searches for a key have been made
+	long probes;	// how many groups those searches have examined
+
+	double max_load;		// grow once more than this fraction of slots is full
+	double growth;			// factor to grow the arrays by each time
+	int nresizes;			// how many times the arrays have been resized
+	long resize_time;		// how much CPU time has been spent resizing
+};
+
+
+/* * * *
+ * helper functions
+ */
+
+// return a bitmask with bit i set if control byte i of the group starting at
+// 'ctrl' is equal to 'byte'
+static unsigned match_byte(uint8_t *ctrl, uint8_t byte) {
+#ifdef __SSE2__
+	__m128i group = _mm_loadu_si128((__m128i *)ctrl);
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(byte)));
+#else
+	unsigned mask = 0;
+	int i;
+	for (i = 0; i < GROUP_WIDTH; i++) {
+		mask |= (unsigned)(ctrl[i] == byte) << i;
+	}
+	return mask;
+#endif
+}
+
+// return a bitmask with bit i set if slot i of the group starting at 'ctrl'
+// is free (empty)
+static unsigned match_free(uint8_t *ctrl) {
+#ifdef __SSE2__
+	// free control bytes are exactly the ones with their high bit set
+	return _mm_movemask_epi8(_mm_loadu_si128((__m128i *)ctrl));
+#else
+	unsigned mask = 0;
+	int i;
+	for (i = 0; i < GROUP_WIDTH; i++) {
+		mask |= (unsigned)(ctrl[i] >> 7) << i;
+	}
+	return mask;
+#endif
+}
+
+// return the index of the lowest set bit in nonzero 'mask'
+static int lowest_bit(unsigned mask) {
+#if defined(__GNUC__)
+	return __builtin_ctz(mask);
+#else
+	int i = 0;
+	while (!(mask & 1)) {
+		mask >>= 1;
+		i++;
+	}
+	return i;
+#endif
+}
+
+// the tag to store in the control byte of a key with (unreduced) hash 'hash'
+// hash_address picks the group from the high bits of the hash (or from the
+// low bits, with REFERENCE_HASH), so neither end of the hash is worth much
+// inside one group: take the tag from the top bits of a multiplicative mix
+// of the whole hash instead
+static uint8_t hash_tag(int hash) {
+	return (uint8_t)(((uint32_t)hash * 0x9e3779b1u) >> 25);
+}
+
+// the group after group 'g', wrapping around to the start of the table
+static int next_group(SwissHashTable *table, int g) {
+	g++;
+	return g == table->ngroups ? 0 : g;
+}
+
+// prefetch the memory needed to search the home group of (unreduced) 'hash'
+static void prefetch_group(SwissHashTable *table, int hash) {
+	int g = hash_address(hash, table->ngroups);
+	prefetch(&table->ctrl[g * GROUP_WIDTH]);
+	prefetch(&table->slots[g * GROUP_WIDTH]);
+}
+
+
+// set up the internals of a swiss hash table struct with new arrays of
+// 'ngroups' groups
+static void initialise_table(SwissHashTable *table, int ngroups) {
+	int size = ngroups * GROUP_WIDTH;
+	assert(size < MAX_TABLE_SIZE && "error: table has grown too large!");
+
+	table->ctrl = malloc((sizeof *table->ctrl) * size);
+	assert(table->ctrl);
+	table->slots = malloc((sizeof *table->slots) * size);
+	assert(table->slots);
+	int i;
+	for (i = 0; i < size; i++) {
+		table->ctrl[i] = CTRL_EMPTY;
+	}
+
+	table->ngroups = ngroups;
+	table->size = size;
+	table->load = 0;
+}
+
+
+// search 'table' for 'key', which has (unreduced) hash 'hash'
+// returns the address of the slot holding the key, or -1 if it's not there
+static int find_slot(SwissHashTable *table, int64 key, int hash) {
+	uint8_t tag = hash_tag(hash);
+	int g = hash_address(hash, table->ngroups);
+	table->searches++;
+
+	int probes;
+	for (probes = 0; probes < table->ngroups; probes++) {
+		table->probes++;
+		uint8_t *ctrl = &table->ctrl[g * GROUP_WIDTH];
+
+		// only compare the keys whose tags match
+		unsigned matches = match_byte(ctrl, tag);
+		while (matches) {
+			int h = g * GROUP_WIDTH + lowest_bit(matches);
+			if (table->slots[h] == key) {
+				return h;
+			}
+			matches &= matches - 1;
+		}
+
+		// the key would have been put in this group if it had any room
+		if (match_byte(ctrl, CTRL_EMPTY)) {
+			return -1;
+		}
+		g = next_group(table, g);
+	}
+
+	// we've been through every group
+	return -1;
+}
+
+// put 'key', which has (unreduced) hash 'hash' and isn't already in 'table',
+// into the first free slot along its search path
+static void place_key(SwissHashTable *table, int64 key, int hash) {
+	int g = hash_address(hash, table->ngroups);
+
+	// the maximum load factor guarantees we'll find a free slot
+	unsigned frees;
+	while (!(frees = match_free(&table->ctrl[g * GROUP_WIDTH]))) {
+		g = next_group(table, g);
+	}
+
+	int h = g * GROUP_WIDTH + lowest_bit(frees);
+	table->ctrl[h] = hash_tag(hash);
+	table->slots[h] = key;
+	table->load++;
+}
+
+// resize the internal table arrays to 'ngroups' groups and re-hash all keys
+// in the old arrays
+static void resize_table(SwissHashTable *table, int ngroups) {
+	long start_time = clock();
+
+	uint8_t *oldctrl = table->ctrl;
+	int64 *oldslots = table->slots;
+	int oldsize = table->size;
+
+	// gather the old keys together so they can all be hashed at once
+	int64 *keys = malloc((sizeof *keys) * oldsize);
+	assert(keys);
+	int *hashes = malloc((sizeof *hashes) * oldsize);
+	assert(hashes);
+	int i, nkeys = 0;
+	for (i = 0; i < oldsize; i++) {
+		if (!(oldctrl[i] & CTRL_EMPTY)) {
+			keys[nkeys++] = oldslots[i];
+		}
+	}
+	h1_multi(keys, nkeys, hashes);
+
+	initialise_table(table, ngroups);
+	for (i = 0; i < nkeys; i++) {
+		place_key(table, keys[i], hashes[i]);
+	}
+
+	free(keys);
+	free(hashes);
+	free(oldctrl);
+	free(oldslots);
+
+	table->nresizes++;
+	table->resize_time += clock() - start_time;
+}
+
+// insert 'key', which has (unreduced) hash 'hash', into 'table'
+// returns true if insertion succeeds, false if it was already in there
+static bool insert_hashed(SwissHashTable *table, int64 key, int hash) {
+	if (find_slot(table, key, hash) >= 0) {
+		return false;
+	}
+
+	// make some more space first if this key would take us past the
+	// maximum load factor
+	if (table->load + 1 > table->max_load * table->size) {
+		int ngroups = table->ngroups * table->growth;
+		resize_table(table,
+			ngroups > table->ngroups ? ngroups : table->ngroups + 1);
+	}
+
+	place_key(table, key, hash);
+	return true;
+}
+
+
+/* * * *
+ * all functions
+ */
+
+// initialise a swiss hash table with room for at least 'size' slots, growing
+// according to the resize policy in 'options'
+SwissHashTable *new_swiss_hash_table(int size, TableOptions *options) {
+	SwissHashTable *table = malloc(sizeof *table);
+	assert(table);
+
+	// the table must always have an empty slot somewhere
+	table->max_load = options->max_load;
+	if (table->max_load > MAX_MAX_LOAD) {
+		table->max_load = MAX_MAX_LOAD;
+	}
+	table->growth = options->growth;
+	table->nresizes = 0;
+	table->resize_time = 0;
+	table->searches = 0;
+	table->probes = 0;
+
+	// round the size up to a whole number of groups
+	initialise_table(table, (size + GROUP_WIDTH - 1) / GROUP_WIDTH);
+
+	return table;
+}
+
+
+// free all memory associated with 'table'
+void free_swiss_hash_table(SwissHashTable *table) {
+	assert(table != NULL);
+
+	// free the table's arrays
+	free(table->ctrl);
+	free(table->slots);
+
+	// free the table struct itself
+	free(table);
+}
+
+
+// insert 'key' into 'table', if it's not in there already
+// returns true if insertion succeeds, false if it was already in there
+bool swiss_hash_table_insert(SwissHashTable *table, int64 key) {
+	assert(table != NULL);
+
+	return insert_hashed(table, key, h1(key));
+}
+
+
+// insert the 'n' keys in 'keys' into 'table', in order, setting bit i of the
+// bitmap 'results' if keys[i] was inserted (clearing it if already there)
+// returns the number of keys inserted
+int swiss_hash_table_insert_batch(SwissHashTable *table, int64 *keys, int n,
+	uint8_t *results) {
+	assert(table != NULL);
+
+	// hash keys BATCH_WINDOW ahead of the one being inserted, and prefetch
+	// the groups they will start searching from
+	int hashes[BATCH_WINDOW];
+	int i, ninserted = 0;
+	for (i = 0; i < n && i < BATCH_WINDOW; i++) {
+		hashes[i] = h1(keys[i]);
+		prefetch_group(table, hashes[i]);
+	}
+
+	for (i = 0; i < n; i++) {
+		int hash = hashes[i % BATCH_WINDOW];
+
+		// refill this window entry with the key BATCH_WINDOW ahead
+		// (if the table grows in the meantime, the prefetch is just wasted)
+		if (i + BATCH_WINDOW < n) {
+			int next = h1(keys[i + BATCH_WINDOW]);
+			hashes[i % BATCH_WINDOW] = next;
+			prefetch_group(table, next);
+		}
+
+		bool inserted = insert_hashed(table, keys[i], hash);
+		bitmap_set(results, i, inserted);
+		ninserted += inserted;
+	}
+
+	return ninserted;
+}
+
+
+// lookup whether 'key' is inside 'table'
+// returns true if found, false if not
+bool swiss_hash_table_lookup(SwissHashTable *table, int64 key) {
+	assert(table != NULL);
+
+	return find_slot(table, key, h1(key)) >= 0;
+}
+
+
+// lookup each of the 'n' keys in 'keys', setting bit i of the bitmap
+// 'results' if keys[i] is inside 'table' (clearing it if not)
+// returns the number of keys found
+int swiss_hash_table_lookup_batch(SwissHashTable *table, int64 *keys, int n,
+	uint8_t *results) {
+	assert(table != NULL);
+
+	// pipeline: hash and prefetch BATCH_WINDOW keys ahead of the one searched
+	int hashes[BATCH_WINDOW];
+	int i, nfound = 0;
+	for (i = 0; i < n && i < BATCH_WINDOW; i++) {
+		hashes[i] = h1(keys[i]);
+		prefetch_group(table, hashes[i]);
+	}
+
+	for (i = 0; i < n; i++) {
+		int hash = hashes[i % BATCH_WINDOW];
+
+		if (i + BATCH_WINDOW < n) {
+			int next = h1(keys[i + BATCH_WINDOW]);
+			hashes[i % BATCH_WINDOW] = next;
+			prefetch_group(table, next);
+		}
+
+		bool found = find_slot(table, keys[i], hash) >= 0;
+		bitmap_set(results, i, found);
+		nfound += found;
+	}
+
+	return nfound;
+}
+
+
+// the number of keys 'table' has slots for right now (though it grows before
+// they are all full)
+int swiss_hash_table_capacity(SwissHashTable *table) {
+	assert(table != NULL);
+	return table->size;
+}
+
+
+// print the contents of 'table' to stdout
+void swiss_hash_table_print(SwissHashTable *table) {
+	assert(table != NULL);
+
+	printf("--- table size: %d (%d groups of %d)\n", table->size,
+		table->ngroups, GROUP_WIDTH);
+
+	// print header
+	printf("   address | tag | key\n");
+
+	// print the rows of the hash table
+	int i;
+	for (i = 0; i < table->size; i++) {
+
+		// print the address
+		printf(" %*d | ", 9, i);
+
+		// print the contents of the slot
+		if (table->ctrl[i] == CTRL_EMPTY) {
+			printf("  - | -\n");
+		} else {
+			printf("%3d | %llu\n", table->ctrl[i], table->slots[i]);
+		}
+	}
+
+	printf("--- end table ---\n");
+}
+
+
+// print some statistics about 'table' to stdout
+void swiss_hash_table_stats(SwissHashTable *table) {
+	assert(table != NULL);
+	printf("--- table stats ---\n");
+
+	// print some information about the table
+	printf("current size: %d slots (%d groups)\n", table->size, table->ngroups);
+	printf("current load: %d items\n", table->load);
+	printf(" load factor: %.3f%%\n", table->load * 100.0 / table->size);
+#ifdef __SSE2__
+	printf(" group match: sse2\n");
+#else
+	printf(" group match: scalar\n");
+#endif
+	printf("  avg probes: %.3f groups/search\n",
+		table->searches ? table->probes * 1.0 / table->searches : 0);
+	printf("     resizes: %d\n", table->nresizes);
+
+	// also calculate CPU time spent resizing in seconds and print this
+	float seconds = table->resize_time * 1.0 / CLOCKS_PER_SEC;
+	printf(" resize time: %.6f sec\n", seconds);
+
+	printf("--- end stats ---\n");
+}
+
+
+// fill 'stats' with statistics about 'table'
+void swiss_hash_table_get_stats(SwissHashTable *table, HashStats *stats) {
+	assert(table != NULL);
+	init_hash_stats(stats);
+
+	stats->load = table->load;
+	stats->capacity = table->size;
+	stats->memory = (long)table->size
+		* (sizeof *table->ctrl + sizeof *table->slots);
+	stats->probes = table->probes;
+	stats->resizes = table->nresizes;
+	stats->resize_time = table->resize_time * 1.0 / CLOCKS_PER_SEC;
+}
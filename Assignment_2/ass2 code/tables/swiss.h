@@ -0,0 +1,60 @@
+/* * * * * * * * *
+ * Dynamic hash table in the style of a SwissTable: open addressing over
+ * groups of 16 slots, with a parallel array of 1-byte control tags that lets
+ * a whole group be searched with a couple of vector instructions
+ *
+ * created for COMP20007 Design of Algorithms - Assignment 2, 2017
+ * by Max Philip
+ */
+
+#ifndef SWISS_H
+#define SWISS_H
+
+#include <stdbool.h>
+#include "../inthash.h"
+#include "../options.h"
+#include "../hashstats.h"
+
+typedef struct swiss_table SwissHashTable;
+
+// initialise a swiss hash table with room for at least 'size' slots, growing
+// according to the resize policy in 'options'
+SwissHashTable *new_swiss_hash_table(int size, TableOptions *options);
+
+// free all memory associated with 'table'
+void free_swiss_hash_table(SwissHashTable *table);
+
+// insert 'key' into 'table', if it's not in there already
+// returns true if insertion succeeds, false if it was already in there
+bool swiss_hash_table_insert(SwissHashTable *table, int64 key);
+
+// insert the 'n' keys in 'keys' into 'table', in order, setting bit i of the
+// bitmap 'results' if keys[i] was inserted (clearing it if already there)
+// returns the number of keys inserted
+int swiss_hash_table_insert_batch(SwissHashTable *table, int64 *keys, int n,
+	uint8_t *results);
+
+// lookup whether 'key' is inside 'table'
+// returns true if found, false if not
+bool swiss_hash_table_lookup(SwissHashTable *table, int64 key);
+
+// lookup each of the 'n' keys in 'keys', setting bit i of the bitmap
+// 'results' if keys[i] is inside 'table' (clearing it if not)
+// returns the number of keys found
+int swiss_hash_table_lookup_batch(SwissHashTable *table, int64 *keys, int n,
+	uint8_t *results);
+
+// the number of keys 'table' has slots for right now (though it grows before
+// they are all full)
+int swiss_hash_table_capacity(SwissHashTable *table);
+
+// print the contents of 'table' to stdout
+void swiss_hash_table_print(SwissHashTable *table);
+
+// print some statistics about 'table' to stdout
+void swiss_hash_table_stats(SwissHashTable *table);
+
+// fill 'stats' with statistics about 'table'
+void swiss_hash_table_get_stats(SwissHashTable *table, HashStats *stats);
+
+#endif
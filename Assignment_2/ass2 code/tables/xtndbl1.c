@@ -12,6 +12,9 @@
 #include <time.h>
 
 #include "xtndbl1.h"
+#include "../batch.h"
+#include "../slab.h"
+#include "../directory.h"
 
 // macro to calculate the rightmost n bits of a number x
 #define rightmostnbits(n, x) (x) & ((1 << (n)) - 1)
@@ -25,6 +28,9 @@ typedef struct bucket {
 	int depth;	// how many hash value bits are being used by this bucket
 	bool full;	// does this bucket contain a key
 	int64 key;	// the key stored in this bucket
+	struct bucket *overflow;	// the next bucket in this bucket's overflow
+				// chain (only once it can't split), or NULL; every
+				// bucket in a chain is full
 } Bucket;
 
 // helper structure to store statistics gathered
@@ -33,15 +39,27 @@ typedef struct stats {
 	int nkeys;		// how many keys are being stored in the table
 	int time;		// how much CPU time has been used to insert/lookup keys
 					// in this table
+	int nsplits;	// how many times a bucket has been split
+	int nresizes;	// how many times the directory has been doubled or halved
+	long resize_time;	// how much of that CPU time was spent resizing it
+	int noverflow;	// how many overflow buckets are chained to buckets
+	int nrejected;	// how many insertions were refused for want of room
 } Stats;
 
 // a hash table is an array of slots pointing to buckets holding up to 1 key,
 // along with some usage statistics and information about the number of hash
 // value bits to use for addressing
 struct xtndbl1_table {
-	Bucket **buckets;	// array of pointers to buckets
+	Directory dir;		// table of pointers to buckets, each tagged with
+						// whether its bucket is full and a fingerprint of
+						// the key (see directory.h)
 	int size;			// how many entries in the table of pointers (2^depth)
 	int depth;			// how many bits of the hash value to use (log2(size))
+	int ndeep;			// how many buckets use all 'depth' bits (when there
+						// are none, the table can be halved)
+	int max_depth;		// most hash value bits a bucket can use
+	int max_chain;		// most overflow buckets a bucket can chain on
+	Slab *slab;			// the memory that every bucket is allocated from
 	Stats stats;		// collection of statistics about this hash table
 };
 
@@ -49,36 +67,141 @@ struct xtndbl1_table {
  * helper functions
  */
 
-// create a new bucket first referenced from 'first_address', based on 'depth'
-// bits of its keys' hash values
-static Bucket *new_bucket(int first_address, int depth) {
-	Bucket *bucket = malloc(sizeof *bucket);
-	assert(bucket);
+// create a new bucket in 'table' first referenced from 'first_address', based
+// on 'depth' bits of its keys' hash values
+static Bucket *new_bucket(Xtndbl1HashTable *table, int first_address,
+		int depth) {
+	Bucket *bucket = slab_alloc(table->slab);
 
 	bucket->id = first_address;
 	bucket->depth = depth;
 	bucket->full = false;
+	bucket->overflow = NULL;
 
 	return bucket;
 }
 
+// the directory entry for 'bucket': its pointer, tagged with its key (or
+// untagged, if it has an overflow chain holding other keys too)
+static void *bucket_entry(Bucket *bucket) {
+	if (bucket->overflow) {
+		return dir_untagged_entry(bucket);
+	}
+	return dir_entry(bucket, bucket->full, bucket->key);
+}
+
+// the bucket that address 'address' of 'table' points to
+static Bucket *get_bucket(Xtndbl1HashTable *table, int address) {
+	return entry_pointer(dir_get(&table->dir, address));
+}
+
+// retag the directory entry that a lookup for 'key' reads, after 'bucket'
+// (which that entry points to) has taken 'key' in or given it up. no other
+// entry pointing to the bucket needs its tag kept up to date: a lookup
+// arriving there is for some other key, which can't be in the bucket, and
+// a stale tag only costs it a trip to the bucket to find that out (a bucket
+// with an overflow chain uses every hash value bit, so has just one entry)
+static void tag_entry(Xtndbl1HashTable *table, Bucket *bucket, int64 key) {
+	int address = rightmostnbits(table->depth, h1(key));
+	dir_retag(&table->dir, address, bucket_entry(bucket));
+}
+
+// does 'bucket', or its overflow chain, hold 'key'?
+static bool bucket_holds(Bucket *bucket, int64 key) {
+	for (; bucket; bucket = bucket->overflow) {
+		if (bucket->full && bucket->key == key) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// put 'key' in a new overflow bucket at the end of full bucket 'bucket's
+// chain, unless the chain is already as long as it's allowed to be
+// returns true if the key was chained, false if there was no room
+static bool chain_key(Xtndbl1HashTable *table, Bucket *bucket, int64 key) {
+	int nchained = 0;
+	while (bucket->overflow) {
+		bucket = bucket->overflow;
+		nchained++;
+	}
+	if (nchained == table->max_chain) {
+		return false;
+	}
+
+	bucket->overflow = new_bucket(table, bucket->id, bucket->depth);
+	bucket->overflow->key = key;
+	bucket->overflow->full = true;
+	table->stats.noverflow++;
+	return true;
+}
+
+// remove 'key' from 'bucket' or its overflow chain, which must hold it,
+// keeping the chain as short as possible: the last bucket in the chain fills
+// the gap with its key, and is dropped
+static void unchain_key(Xtndbl1HashTable *table, Bucket *bucket, int64 key) {
+	Bucket *node = bucket;
+	while (node->key != key) {
+		node = node->overflow;
+	}
+	if (!bucket->overflow) {
+		bucket->full = false;
+		return;
+	}
+
+	Bucket *prev = bucket, *last = bucket->overflow;
+	while (last->overflow) {
+		prev = last;
+		last = last->overflow;
+	}
+	node->key = last->key;
+	prev->overflow = NULL;
+	slab_release(table->slab, last);
+	table->stats.noverflow--;
+}
+
 // double the table of bucket pointers, duplicating the bucket pointers in the
-// first half into the new second half of the table
+// first half into the new second half of the table (or, for a lazy directory,
+// letting the second half stand in for the first until it's written)
 static void double_table(Xtndbl1HashTable *table) {
+	long start_time = clock();
 	int size = table->size * 2;
-	assert(size < MAX_TABLE_SIZE && "error: table has grown too large!");
-
-	// get a new array of twice as many bucket pointers, and copy pointers down
-	table->buckets = realloc(table->buckets, (sizeof *table->buckets) * size);
-	assert(table->buckets);
-	int i;
-	for (i = 0; i < table->size; i++) {
-		table->buckets[table->size + i] = table->buckets[i];
-	}
+	dir_grow(&table->dir, table->depth + 1);
 
 	// finally, increase the table size and the depth we are using to hash keys
+	// (no bucket uses the new bit yet)
 	table->size = size;
 	table->depth++;
+	table->ndeep = 0;
+
+	table->stats.nresizes++;
+	table->stats.resize_time += clock() - start_time;
+}
+
+// halve the table of bucket pointers for as long as no bucket uses the last
+// bit of the hash value: the second half is then just a copy of the first
+static void halve_table(Xtndbl1HashTable *table) {
+	while (table->depth > 0 && table->ndeep == 0) {
+		long start_time = clock();
+		table->size /= 2;
+		table->depth--;
+		dir_shrink(&table->dir, table->depth);
+
+		// count the buckets that use every bit at the new depth, and retag
+		// the entry each key is now looked up at (it may have been in the
+		// half that was dropped)
+		int i;
+		for (i = 0; i < table->size; i++) {
+			Bucket *bucket = get_bucket(table, i);
+			table->ndeep += bucket->id == i && bucket->depth == table->depth;
+			if (bucket->id == i && bucket->full) {
+				tag_entry(table, bucket, bucket->key);
+			}
+		}
+
+		table->stats.nresizes++;
+		table->stats.resize_time += clock() - start_time;
+	}
 }
 
 // reinsert a key into the hash table after splitting a bucket --- we can assume
@@ -86,9 +209,10 @@ static void double_table(Xtndbl1HashTable *table) {
 // inside the hash table previously
 // use 'xtndbl1_hash_table_insert()' instead for inserting new keys
 static void reinsert_key(Xtndbl1HashTable *table, int64 key) {
-	int address = rightmostnbits(table->depth, h1(key));
-	table->buckets[address]->key = key;
-	table->buckets[address]->full = true;
+	Bucket *bucket = get_bucket(table, rightmostnbits(table->depth, h1(key)));
+	bucket->key = key;
+	bucket->full = true;
+	tag_entry(table, bucket, key);
 }
 
 // split the bucket in 'table' at address 'address', growing table if necessary
@@ -96,7 +220,7 @@ static void split_bucket(Xtndbl1HashTable *table, int address) {
 
 	// FIRST,
 	// do we need to grow the table?
-	if (table->buckets[address]->depth == table->depth) {
+	if (get_bucket(table, address)->depth == table->depth) {
 		// yep, this bucket is down to its last pointer
 		double_table(table);
 	}
@@ -105,7 +229,7 @@ static void split_bucket(Xtndbl1HashTable *table, int address) {
 
 	// SECOND,
 	// create a new bucket and update both buckets' depth
-	Bucket *bucket = table->buckets[address];
+	Bucket *bucket = get_bucket(table, address);
 	int depth = bucket->depth;
 	int first_address = bucket->id;
 
@@ -114,11 +238,13 @@ static void split_bucket(Xtndbl1HashTable *table, int address) {
 
 	// new bucket's first address will be a 1 bit plus the old first address
 	int new_first_address = 1 << depth | first_address;
-	Bucket *newbucket = new_bucket(new_first_address, new_depth);
+	Bucket *newbucket = new_bucket(table, new_first_address, new_depth);
 	table->stats.nbuckets++;
+	table->stats.nsplits++;
 
 	// THIRD,
 	// redirect every second address pointing to this bucket to the new bucket
+	// (which is empty for now)
 	// construct addresses by joining a bit 'prefix' and a bit 'suffix'
 	// (defined below)
 
@@ -138,7 +264,12 @@ static void split_bucket(Xtndbl1HashTable *table, int address) {
 		int a = (prefix << new_depth) | suffix;
 
 		// redirect this table entry to point at the new bucket
-		table->buckets[a] = newbucket;
+		dir_set(&table->dir, a, bucket_entry(newbucket));
+	}
+
+	if (new_depth == table->depth) {
+		// both buckets now use every bit of the table's depth
+		table->ndeep += 2;
 	}
 
 	// FINALLY,
@@ -151,25 +282,86 @@ static void split_bucket(Xtndbl1HashTable *table, int address) {
 	reinsert_key(table, key);
 }
 
+// merge 'bucket' with its buddy (the bucket it was split from, or that was
+// split from it) if both use the same number of hash value bits and there is
+// at most one key between them
+// returns the merged bucket, or NULL if they could not be merged
+static Bucket *merge_buddies(Xtndbl1HashTable *table, Bucket *bucket) {
+	int depth = bucket->depth;
+	if (depth == 0) {
+		// this bucket is the whole table
+		return NULL;
+	}
+
+	// the buddy's first address differs in the last bit this bucket uses
+	int bit = 1 << (depth - 1);
+	Bucket *buddy = get_bucket(table, bucket->id ^ bit);
+	if (buddy->depth != depth || bucket->overflow || buddy->overflow
+			|| (bucket->full && buddy->full)) {
+		return NULL;
+	}
+
+	// keep the bucket without that bit in its first address, since it is
+	// still the first address of the merged bucket
+	Bucket *keep = bucket, *gone = buddy;
+	if (bucket->id & bit) {
+		keep = buddy;
+		gone = bucket;
+	}
+	if (gone->full) {
+		keep->key = gone->key;
+		keep->full = true;
+	}
+	keep->depth = depth - 1;
+	if (depth == table->depth) {
+		table->ndeep -= 2;
+	}
+
+	// redirect every address pointing to the removed bucket (all prefixes
+	// joined to its first address, as in splitting) to the merged bucket,
+	// tagged with its key (its own addresses already are, if it had one)
+	int maxprefix = 1 << (table->depth - depth);
+	int prefix;
+	for (prefix = 0; prefix < maxprefix; prefix++) {
+		dir_set(&table->dir, (prefix << depth) | gone->id, bucket_entry(keep));
+	}
+
+	slab_release(table->slab, gone);
+	table->stats.nbuckets--;
+	return keep;
+}
+
 
 /* * * *
  * all functions
  */
 
-// initialise a single-key extendible hash table
-Xtndbl1HashTable *new_xtndbl1_hash_table() {
+// initialise a single-key extendible hash table, with 'options' (see
+// options.h) such as a lazily growing directory, and chaining overflow
+// buckets past 'options->max_depth' hash bits
+Xtndbl1HashTable *new_xtndbl1_hash_table(TableOptions *options) {
 	Xtndbl1HashTable *table = malloc(sizeof *table);
 	assert(table);
 
+	table->slab = new_slab(sizeof (Bucket));
+
 	table->size = 1;
-	table->buckets = malloc(sizeof *table->buckets);
-	assert(table->buckets);
-	table->buckets[0] = new_bucket(0, 0);
+	dir_init(&table->dir, options->lazy_directory);
+	Bucket *bucket = new_bucket(table, 0, 0);
+	dir_set(&table->dir, 0, bucket_entry(bucket));
 	table->depth = 0;
+	table->ndeep = 1;
+	table->max_depth = options->max_depth;
+	table->max_chain = options->max_chain;
 
 	table->stats.nbuckets = 1;
 	table->stats.nkeys = 0;
 	table->stats.time = 0;
+	table->stats.nsplits = 0;
+	table->stats.nresizes = 0;
+	table->stats.resize_time = 0;
+	table->stats.noverflow = 0;
+	table->stats.nrejected = 0;
 
 	return table;
 }
@@ -179,18 +371,11 @@ Xtndbl1HashTable *new_xtndbl1_hash_table() {
 void free_xtndbl1_hash_table(Xtndbl1HashTable *table) {
 	assert(table);
 
-	// loop backwards through the array of pointers, freeing buckets only as we
-	// reach their first reference
-	// (if we loop through forwards, we wouldn't know which reference was last)
-	int i;
-	for (i = table->size-1; i >= 0; i--) {
-		if (table->buckets[i]->id == i) {
-			free(table->buckets[i]);
-		}
-	}
+	// free all of the buckets at once, along with the slab holding them
+	free_slab(table->slab);
 
 	// free the array of bucket pointers
-	free(table->buckets);
+	dir_free(&table->dir);
 
 	// free the table struct itself
 	free(table);
@@ -198,7 +383,8 @@ void free_xtndbl1_hash_table(Xtndbl1HashTable *table) {
 
 
 // insert 'key' into 'table', if it's not in there already
-// returns true if insertion succeeds, false if it was already in there
+// returns true if insertion succeeds, false if it was already in there (or
+// there was no room for it: see 'max_chain' in options.h)
 bool xtndbl1_hash_table_insert(Xtndbl1HashTable *table, int64 key) {
 	assert(table);
 	int start_time = clock(); // start timing
@@ -208,22 +394,33 @@ bool xtndbl1_hash_table_insert(Xtndbl1HashTable *table, int64 key) {
 	int address = rightmostnbits(table->depth, hash);
 
 	// is this key already there?
-	if (table->buckets[address]->full && table->buckets[address]->key == key) {
+	Bucket *bucket = get_bucket(table, address);
+	if (bucket_holds(bucket, key)) {
 		table->stats.time += clock() - start_time; // add time elapsed
 		return false;
 	}
 
-	// if not, make space in the table until our target bucket has space
-	while (table->buckets[address]->full) {
+	// if not, make space in the table until our target bucket has space (or
+	// it uses as many hash value bits as it's allowed to)
+	while (bucket->full && bucket->depth < table->max_depth) {
 		split_bucket(table, address);
 
 		// and recalculate address because we might now need more bits
 		address = rightmostnbits(table->depth, hash);
+		bucket = get_bucket(table, address);
 	}
 
-	// there's now space! we can insert this key
-	table->buckets[address]->key = key;
-	table->buckets[address]->full = true;
+	// there's now space! we can insert this key (in an overflow bucket, if
+	// the bucket couldn't be split any further)
+	if (!bucket->full) {
+		bucket->key = key;
+		bucket->full = true;
+	} else if (!chain_key(table, bucket, key)) {
+		table->stats.nrejected++; // no room for it
+		table->stats.time += clock() - start_time; // add time elapsed
+		return false;
+	}
+	tag_entry(table, bucket, key);
 	table->stats.nkeys++;
 
 	// add time elapsed to total CPU time before returning
@@ -241,11 +438,13 @@ bool xtndbl1_hash_table_lookup(Xtndbl1HashTable *table, int64 key) {
 	// calculate table address for this key
 	int address = rightmostnbits(table->depth, h1(key));
 
-	// look for the key in that bucket (unless it's empty)
+	// look for the key in that bucket, unless the directory entry already
+	// shows that it's empty or holds a different key
+	void *entry = dir_get(&table->dir, address);
 	bool found = false;
-	if (table->buckets[address]->full) {
+	if (entry_may_hold(entry, key)) {
 		// found it?
-		found = table->buckets[address]->key == key;
+		found = bucket_holds(entry_pointer(entry), key);
 	}
 
 	// add time elapsed to total CPU time before returning result
@@ -254,6 +453,104 @@ bool xtndbl1_hash_table_lookup(Xtndbl1HashTable *table, int64 key) {
 }
 
 
+// delete 'key' from 'table', if it's in there
+// returns true if deletion succeeds, false if it wasn't in there
+bool xtndbl1_hash_table_delete(Xtndbl1HashTable *table, int64 key) {
+	assert(table);
+	int start_time = clock(); // start timing
+
+	// calculate table address for this key
+	int address = rightmostnbits(table->depth, h1(key));
+	Bucket *bucket = get_bucket(table, address);
+
+	// is the key there to delete?
+	if (!bucket_holds(bucket, key)) {
+		table->stats.time += clock() - start_time; // add time elapsed
+		return false;
+	}
+	unchain_key(table, bucket, key);
+	tag_entry(table, bucket, key);
+	table->stats.nkeys--;
+
+	// merge emptied-out buckets back together for as long as possible, then
+	// shrink the table if no bucket needs all of it any more
+	while (bucket) {
+		bucket = merge_buddies(table, bucket);
+	}
+	halve_table(table);
+
+	// add time elapsed to total CPU time before returning
+	table->stats.time += clock() - start_time;
+	return true;
+}
+
+
+// insert the 'n' keys in 'keys' into 'table', in order, setting bit i of the
+// bitmap 'results' if keys[i] was inserted (clearing it if already there)
+// returns the number of keys inserted
+int xtndbl1_hash_table_insert_batch(Xtndbl1HashTable *table, int64 *keys,
+	int n, uint8_t *results) {
+	assert(table);
+
+	// prefetch the directory entry of the key BATCH_WINDOW ahead of the one
+	// being inserted (splits may redirect it, but most inserts don't split)
+	int i, ninserted = 0;
+	for (i = 0; i < n && i < BATCH_WINDOW; i++) {
+		dir_prefetch(&table->dir, rightmostnbits(table->depth, h1(keys[i])));
+	}
+	for (i = 0; i < n; i++) {
+		if (i + BATCH_WINDOW < n) {
+			int hash = h1(keys[i + BATCH_WINDOW]);
+			dir_prefetch(&table->dir, rightmostnbits(table->depth, hash));
+		}
+		bool inserted = xtndbl1_hash_table_insert(table, keys[i]);
+		bitmap_set(results, i, inserted);
+		ninserted += inserted;
+	}
+
+	return ninserted;
+}
+
+
+// lookup each of the 'n' keys in 'keys', setting bit i of the bitmap
+// 'results' if keys[i] is inside 'table' (clearing it if not)
+// returns the number of keys found
+int xtndbl1_hash_table_lookup_batch(Xtndbl1HashTable *table, int64 *keys,
+	int n, uint8_t *results) {
+	assert(table);
+	int start_time = clock(); // start timing
+
+	// the key BATCH_WINDOW ahead has its directory entry prefetched; the
+	// entry's tag rules out almost every miss, so buckets are only read for
+	// likely hits and aren't worth a second pipeline stage
+	int addresses[BATCH_WINDOW];
+	int i, nfound = 0;
+	for (i = 0; i < n && i < BATCH_WINDOW; i++) {
+		addresses[i] = rightmostnbits(table->depth, h1(keys[i]));
+		dir_prefetch(&table->dir, addresses[i]);
+	}
+
+	for (i = 0; i < n; i++) {
+		void *entry = dir_get(&table->dir, addresses[i % BATCH_WINDOW]);
+
+		if (i + BATCH_WINDOW < n) {
+			int next = rightmostnbits(table->depth, h1(keys[i + BATCH_WINDOW]));
+			addresses[i % BATCH_WINDOW] = next;
+			dir_prefetch(&table->dir, next);
+		}
+
+		bool found = entry_may_hold(entry, keys[i])
+			&& bucket_holds(entry_pointer(entry), keys[i]);
+		bitmap_set(results, i, found);
+		nfound += found;
+	}
+
+	// add time elapsed to total CPU time before returning result
+	table->stats.time += clock() - start_time;
+	return nfound;
+}
+
+
 // print the contents of 'table' to stdout
 void xtndbl1_hash_table_print(Xtndbl1HashTable *table) {
 	assert(table);
@@ -267,16 +564,21 @@ void xtndbl1_hash_table_print(Xtndbl1HashTable *table) {
 	int i;
 	for (i = 0; i < table->size; i++) {
 		// table entry
-		printf("%9d | %-9d ", i, table->buckets[i]->id);
+		Bucket *bucket = get_bucket(table, i);
+		printf("%9d | %-9d ", i, bucket->id);
 
 		// if this is the first address at which a bucket occurs, print it
-		if (table->buckets[i]->id == i) {
-			printf("%9d ", table->buckets[i]->id);
-			if (table->buckets[i]->full) {
-				printf("[%llu]", table->buckets[i]->key);
+		// (and any overflow chain it has)
+		if (bucket->id == i) {
+			printf("%9d ", bucket->id);
+			if (bucket->full) {
+				printf("[%llu]", bucket->key);
 			} else {
 				printf("[ ]");
 			}
+			while ((bucket = bucket->overflow)) {
+				printf(" -> [%llu]", bucket->key);
+			}
 		}
 
 		// end the line
@@ -297,6 +599,13 @@ void xtndbl1_hash_table_stats(Xtndbl1HashTable *table) {
 	printf("current table size: %d\n", table->size);
 	printf("    number of keys: %d\n", table->stats.nkeys);
 	printf(" number of buckets: %d\n", table->stats.nbuckets);
+	printf("  overflow buckets: %d (past depth %d)\n", table->stats.noverflow,
+		table->max_depth);
+	printf("     rejected keys: %d (chains of %d)\n", table->stats.nrejected,
+		table->max_chain);
+	printf("     bucket memory: %.1f KB\n", slab_bytes(table->slab) / 1024.0);
+	printf("  directory memory: %.1f KB%s\n", dir_bytes(&table->dir) / 1024.0,
+		table->dir.lazy ? " (lazy)" : "");
 
 	// also calculate CPU usage in seconds and print this
 	float seconds = table->stats.time * 1.0 / CLOCKS_PER_SEC;
@@ -304,3 +613,17 @@ void xtndbl1_hash_table_stats(Xtndbl1HashTable *table) {
 
 	printf("--- end stats ---\n");
 }
+
+// fill 'stats' with statistics about 'table'
+void xtndbl1_hash_table_get_stats(Xtndbl1HashTable *table, HashStats *stats) {
+	assert(table);
+	init_hash_stats(stats);
+
+	stats->load = table->stats.nkeys;
+	stats->capacity = table->stats.nbuckets + table->stats.noverflow;
+	stats->memory = slab_bytes(table->slab) + dir_bytes(&table->dir);
+	stats->splits = table->stats.nsplits;
+	stats->resizes = table->stats.nresizes;
+	stats->resize_time = table->stats.resize_time * 1.0 / CLOCKS_PER_SEC;
+	stats->rejected = table->stats.nrejected;
+}
@@ -11,27 +11,51 @@
 
 #include <stdbool.h>
 #include "../inthash.h"
+#include "../options.h"
+#include "../hashstats.h"
 
 typedef struct xtndbl1_table Xtndbl1HashTable;
 
-// initialise a single-key extendible hash table
-Xtndbl1HashTable *new_xtndbl1_hash_table();
+// initialise a single-key extendible hash table, with 'options' (see
+// options.h) such as a lazily growing directory
+Xtndbl1HashTable *new_xtndbl1_hash_table(TableOptions *options);
 
 // free all memory associated with 'table'
 void free_xtndbl1_hash_table(Xtndbl1HashTable *table);
 
 // insert 'key' into 'table', if it's not in there already
-// returns true if insertion succeeds, false if it was already in there
+// returns true if insertion succeeds, false if it was already in there (or
+// there was no room for it: see 'max_chain' in options.h)
 bool xtndbl1_hash_table_insert(Xtndbl1HashTable *table, int64 key);
 
+// insert the 'n' keys in 'keys' into 'table', in order, setting bit i of the
+// bitmap 'results' if keys[i] was inserted (clearing it if already there)
+// returns the number of keys inserted
+int xtndbl1_hash_table_insert_batch(Xtndbl1HashTable *table, int64 *keys, int n,
+	uint8_t *results);
+
+// delete 'key' from 'table', if it's in there, merging buckets and shrinking
+// the table as keys are removed
+// returns true if deletion succeeds, false if it wasn't in there
+bool xtndbl1_hash_table_delete(Xtndbl1HashTable *table, int64 key);
+
 // lookup whether 'key' is inside 'table'
 // returns true if found, false if not
 bool xtndbl1_hash_table_lookup(Xtndbl1HashTable *table, int64 key);
 
+// lookup each of the 'n' keys in 'keys', setting bit i of the bitmap
+// 'results' if keys[i] is inside 'table' (clearing it if not)
+// returns the number of keys found
+int xtndbl1_hash_table_lookup_batch(Xtndbl1HashTable *table, int64 *keys, int n,
+	uint8_t *results);
+
 // print the contents of 'table' to stdout
 void xtndbl1_hash_table_print(Xtndbl1HashTable *table);
 
 // print some statistics about 'table' to stdout
 void xtndbl1_hash_table_stats(Xtndbl1HashTable *table);
 
+// fill 'stats' with statistics about 'table'
+void xtndbl1_hash_table_get_stats(Xtndbl1HashTable *table, HashStats *stats);
+
 #endif
@@ -8,10 +8,15 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include <time.h>
 
 #include "xtndbln.h"
+#include "../batch.h"
+#include "../keysearch.h"
+#include "../slab.h"
+#include "../directory.h"
 
 // macro to calculate the rightmost n bits of a number x
 #define rightmostnbits(n, x) (x) & ((1 << (n)) - 1)
@@ -19,7 +24,8 @@
 
 bool xtndbln_hash_table_lookup(XtndblNHashTable *table, int64 key);
 
-// a bucket stores an array of keys
+// a bucket stores an array of keys, inline after its header so that a lookup
+// touches one block of memory rather than following a pointer to the keys
 // it also knows how many bits are shared between possible keys, and the first
 // table address that references it
 typedef struct xtndbln_bucket {
@@ -27,64 +33,86 @@ typedef struct xtndbln_bucket {
 					// in the table which points to it
 	int depth;		// how many hash value bits are being used by this bucket
 	int nkeys;		// number of keys currently contained in this bucket
-	int64 *keys;	// the keys stored in this bucket
+	struct xtndbln_bucket *overflow;	// the next bucket in this bucket's
+					// overflow chain (only once it can't split), or NULL
+	int64 keys[];	// the keys stored in this bucket (bucketsize of them)
 } Bucket;
 
 // helper structure to store statistics gathered, taken from xtndbl1.c
 typedef struct stats {
 	int nbuckets;	// how many distinct buckets does the table point to
 	int nkeys;		// how many keys are being stored in the table
+	int nsplits;	// how many times a full bucket has been split
+	int noverflow;	// how many overflow buckets are chained to buckets
 	int time;		// how much CPU time has been used to insert/lookup keys
 					// in this table
+	int nresizes;	// how many times the directory has been grown or halved
+	long resize_time;	// how much of that CPU time was spent resizing it
+	int nrejected;	// how many insertions were refused for want of room
 } Stats;
 
 // a hash table is an array of slots pointing to buckets holding up to
 // bucketsize keys, along with some information about the number of hash value
 // bits to use for addressing
 struct xtndbln_table {
-	Bucket **buckets;	// array of pointers to buckets
+	Directory dir;		// table of pointers to buckets
 	int size;			// how many entries in the table of pointers (2^depth)
 	int depth;			// how many bits of the hash value to use (log2(size))
+	int ndeep;			// how many buckets use all 'depth' bits (when there
+						// are none, the directory can be halved)
 	int bucketsize;		// maximum number of keys per bucket
+	int max_depth;		// most hash value bits a bucket can use
+	int max_chain;		// most overflow buckets a bucket can chain on
+	bool sorted;		// are the keys in each bucket kept in sorted order?
+	Slab *slab;			// the memory that every bucket is allocated from
 	Stats stats;		// collection of statistics about this hash table
 };
 
 
 
-// create a new bucket first referenced from 'first_address', based on 'depth'
-// and declared bucketsize
-static Bucket *new_xtndbln_bucket(int first_address, int depth, int bucketsize) {
-	Bucket *bucket = malloc(sizeof *bucket);
-	assert(bucket);
+// create a new bucket in 'table' first referenced from 'first_address', based
+// on 'depth' bits of its keys' hash values
+static Bucket *new_xtndbln_bucket(XtndblNHashTable *table, int first_address,
+		int depth) {
+	Bucket *bucket = slab_alloc(table->slab);
 
 	bucket->id = first_address;
 	bucket->depth = depth;
 	bucket->nkeys = 0;
-
-	bucket->keys = malloc((sizeof *bucket->keys) * bucketsize);
-	assert(bucket->keys);
+	bucket->overflow = NULL;
 
 	return bucket;
 }
 
-// initialise an extendible hash table with 'bucketsize' keys per bucket
-XtndblNHashTable *new_xtndbln_hash_table(int bucketsize){
+// initialise an extendible hash table with 'bucketsize' keys per bucket,
+// keeping each bucket's keys sorted if 'options->sorted' is set
+XtndblNHashTable *new_xtndbln_hash_table(int bucketsize, TableOptions *options){
 	XtndblNHashTable *table = malloc(sizeof *table);
 	assert(table);
 
-	table->buckets = malloc(sizeof *table->buckets);
-	assert(table->buckets);
+	// every bucket is the same size, so they can all come from one slab
+	table->slab = new_slab(sizeof (Bucket) + (sizeof (int64)) * bucketsize);
 
-	table->buckets[0] = new_xtndbln_bucket(0, 0, bucketsize);
+	dir_init(&table->dir, options->lazy_directory);
+	dir_set(&table->dir, 0, new_xtndbln_bucket(table, 0, 0));
 
 	table->size = 1;
 	table->depth = 0;
+	table->ndeep = 1;
 	table->bucketsize = bucketsize;
+	table->sorted = options->sorted;
+	table->max_depth = options->max_depth;
+	table->max_chain = options->max_chain;
 
 	// initialise stats
 	table->stats.nbuckets = 1;
+	table->stats.nsplits = 0;
+	table->stats.noverflow = 0;
 	table->stats.nkeys = 0;
 	table->stats.time = 0;
+	table->stats.nresizes = 0;
+	table->stats.resize_time = 0;
+	table->stats.nrejected = 0;
 
 	return table;
 }
@@ -94,119 +122,285 @@ XtndblNHashTable *new_xtndbln_hash_table(int bucketsize){
 void free_xtndbln_hash_table(XtndblNHashTable *table) {
 	assert(table);
 
-	int i;
-	for (i = table->size-1; i >= 0; i--){
-		if (table->buckets[i]->id == i){
-			free(table->buckets[i]->keys);
-			free(table->buckets[i]);
-		}
-	}
+	// the buckets all live in the slab, so they go all at once
+	free_slab(table->slab);
 
-	free(table->buckets);
+	dir_free(&table->dir);
 	free(table);
 }
 
 
-// double the table of bucket pointers, duplicating the bucket pointers in the
-// first half into the new second half of the table
-static void xtndbln_double_table(XtndblNHashTable *table) {
-	int size = table->size * 2;
-	assert(size < MAX_TABLE_SIZE && "error: table has grown too large!");
+// grow the table of bucket pointers to 2^'depth' entries in one go, with the
+// existing pointers repeated in every new block of the table
+static void xtndbln_grow_table(XtndblNHashTable *table, int depth) {
+	assert(depth < 31 && "error: table has grown too large!");
+	long start_time = clock();
+	dir_grow(&table->dir, depth);
 
-	// get a new array of twice as many bucket pointers, and copy pointers down
-	table->buckets = realloc(table->buckets, (sizeof *table->buckets) * size);
-	assert(table->buckets);
-	int i;
-	for (i = 0; i < table->size; i++) {
-		table->buckets[table->size + i] = table->buckets[i];
-	}
+	// no bucket uses the new bits yet
+	table->size = 1 << depth;
+	table->depth = depth;
+	table->ndeep = 0;
 
-	// finally, increase the table size and the depth we are using to hash keys
-	table->size = size;
-	table->depth++;
+	table->stats.nresizes++;
+	table->stats.resize_time += clock() - start_time;
 }
 
-// reinsert a key into the hash table after splitting a bucket --- we can assume
-// that there will definitely be space for this key because it was already
-// inside the hash table previously
-static void reinsert_key(XtndblNHashTable *table, int64 *keys, int nkeys){
+// halve the table of bucket pointers for as long as no bucket uses the last
+// bit of the hash value: the second half is then just a copy of the first
+static void xtndbln_halve_table(XtndblNHashTable *table) {
+	while (table->depth > 0 && table->ndeep == 0) {
+		long start_time = clock();
+		table->size /= 2;
+		table->depth--;
+		dir_shrink(&table->dir, table->depth);
+
+		// count the buckets that use every bit at the new depth
+		int i;
+		for (i = 0; i < table->size; i++) {
+			Bucket *bucket = dir_get(&table->dir, i);
+			table->ndeep += bucket->id == i && bucket->depth == table->depth;
+		}
 
-	int i;
-	int address;
-	for (i=0; i < nkeys; i++){
-		address = rightmostnbits(table->depth, h1(keys[i]));
-		table->buckets[address]->keys[table->buckets[address]->nkeys] = keys[i];
-		table->buckets[address]->nkeys++;
+		table->stats.nresizes++;
+		table->stats.resize_time += clock() - start_time;
 	}
 }
 
-// split the table
-static void split_xtndbl_table(XtndblNHashTable *table, int address){
+// find the first of the 'n' sorted keys in 'keys' that is not less than
+// 'key' (keys + n if there is none), by a binary search with no branches in
+// its loop: every step halves the range with arithmetic instead of an
+// unpredictable jump, so it costs the same log2(n) steps for every key
+static int64 *lower_bound(int64 *keys, int n, int64 key) {
+	if (n == 0) {
+		return keys;
+	}
+	int64 *base = keys;
+	while (n > 1) {
+		int half = n / 2;
+		// start loading both places the next step could look at, so that the
+		// cache miss for the next step overlaps with this one
+		prefetch(base + half / 2);
+		prefetch(base + half + half / 2);
+		base += (base[half] < key) * half;
+		n -= half;
+	}
+	return base + (*base < key);
+}
 
-	// FIRST,
-	// do we need to grow the table?
-	if (table->buckets[address]->depth == table->depth) {
-		// yep, this bucket is down to its last pointer
-		xtndbln_double_table(table);
+// is 'key' in 'bucket' of 'table', or its overflow chain?
+static bool bucket_contains(XtndblNHashTable *table, Bucket *bucket,
+		int64 key) {
+	for (; bucket; bucket = bucket->overflow) {
+		if (table->sorted) {
+			int64 *found = lower_bound(bucket->keys, bucket->nkeys, key);
+			if (found < bucket->keys + bucket->nkeys && *found == key) {
+				return true;
+			}
+		} else if (keys_contain(bucket->keys, bucket->nkeys, key)) {
+			return true;
+		}
+	}
+	return false;
+}
 
+// add 'key' to 'bucket' of 'table', which must have space for it
+static void bucket_add(XtndblNHashTable *table, Bucket *bucket, int64 key) {
+	int64 *end = bucket->keys + bucket->nkeys;
+	if (table->sorted) {
+		// shift the larger keys up one place to make room
+		int64 *place = lower_bound(bucket->keys, bucket->nkeys, key);
+		memmove(place + 1, place, (end - place) * sizeof *place);
+		*place = key;
+	} else {
+		*end = key;
 	}
-	// either way, now it's time to split this bucket
+	bucket->nkeys++;
+}
 
-	// SECOND,
-	// create a new bucket and update both buckets' depth
-	Bucket *bucket = table->buckets[address];
+// remove 'key' from 'bucket' of 'table', if it's in there
+// returns true if it was removed, false if it wasn't there
+static bool bucket_remove(XtndblNHashTable *table, Bucket *bucket, int64 key) {
+	int64 *end = bucket->keys + bucket->nkeys;
+	int64 *place;
+	if (table->sorted) {
+		// shift the larger keys down one place over the key
+		place = lower_bound(bucket->keys, bucket->nkeys, key);
+		if (place == end || *place != key) {
+			return false;
+		}
+		memmove(place, place + 1, (end - place - 1) * sizeof *place);
+	} else {
+		// move the last key into the key's place
+		for (place = bucket->keys; place < end && *place != key; place++);
+		if (place == end) {
+			return false;
+		}
+		*place = end[-1];
+	}
+	bucket->nkeys--;
+	return true;
+}
+
+// move all keys from bucket 'from' into bucket 'to' of 'table', which must
+// have space for them
+static void bucket_move_keys(XtndblNHashTable *table, Bucket *to, Bucket *from) {
+	if (table->sorted) {
+		// merge the two sorted arrays from the back, largest key first
+		int i = to->nkeys - 1, j = from->nkeys - 1, k = i + j + 1;
+		while (j >= 0) {
+			if (i >= 0 && to->keys[i] > from->keys[j]) {
+				to->keys[k--] = to->keys[i--];
+			} else {
+				to->keys[k--] = from->keys[j--];
+			}
+		}
+	} else {
+		memcpy(to->keys + to->nkeys, from->keys, from->nkeys * sizeof *to->keys);
+	}
+	to->nkeys += from->nkeys;
+	from->nkeys = 0;
+}
+
+// how many hash value bits, starting from bit 'depth', do hash values 'h' and
+// 'g' share? (up to the 31 bits that h1 produces)
+static int shared_bits(int h, int g, int depth) {
+	int differ = (h ^ g) >> depth;
+	return differ ? __builtin_ctz(differ) : 31 - depth;
+}
+
+// split the full bucket at 'address' so that there is room in it for a key
+// with hash value 'hash': work out from the keys in the bucket how many more
+// bits it takes to leave fewer than 'bucketsize' keys alongside the new key,
+// then grow the table and split the bucket to that depth at once, instead of
+// one bit at a time (which, if many keys share bits, splits off an empty
+// bucket and redistributes every key at each step)
+static void split_xtndbl_table(XtndblNHashTable *table, int address, int hash) {
+	Bucket *bucket = dir_get(&table->dir, address);
 	int depth = bucket->depth;
-	int first_address = bucket->id;
-	//
-	int new_depth = depth + 1;
-	bucket->depth = new_depth;
 
-	// new bucket's first address will be a 1 bit plus the old first address
-	int new_first_address = 1 << depth | first_address;
-	Bucket *newbucket = new_xtndbln_bucket(new_first_address, new_depth, table->bucketsize);
-	table->stats.nbuckets++;
+	// FIRST,
+	// count how many keys share each number of further bits with the new key
+	int shared[32] = {0};
+	int i;
+	for (i = 0; i < bucket->nkeys; i++) {
+		shared[shared_bits(h1(bucket->keys[i]), hash, depth)]++;
+	}
 
-	// THIRD,
-	// redirect every second address pointing to this bucket to the new bucket
-	// construct addresses by joining a bit 'prefix' and a bit 'suffix'
-	// (defined below)
+	// the new key's bucket gets the keys that share all of the 'extra' new
+	// bits with it, so find the fewest bits leaving room for one more key
+	// (but no more than the maximum depth: past that, the new key's bucket
+	// may still be full, and will need an overflow bucket)
+	int extra = 31 - depth, nsharing = shared[extra];
+	while (extra > 1 && nsharing + shared[extra - 1] < table->bucketsize) {
+		extra--;
+		nsharing += shared[extra];
+	}
+	if (depth + extra > table->max_depth) {
+		extra = table->max_depth - depth;
+	}
+	int new_depth = depth + extra;
 
-	// suffix: a 1 bit followed by the previous bucket bit address
-	int bit_address = rightmostnbits(depth, first_address);
-	int suffix = (1 << depth) | bit_address;
+	// SECOND,
+	// do we need to grow the table?
+	if (new_depth > table->depth) {
+		xtndbln_grow_table(table, new_depth);
+	}
 
-	// prefix: all bitstrings of length equal to the difference between the new
-	// bucket depth and the table depth
-	// use a for loop to enumerate all possible prefixes less than maxprefix:
-	int maxprefix = 1 << (table->depth - new_depth);
+	// THIRD,
+	// create the new buckets along the new key's path: for each new bit, a
+	// bucket for the keys that first differ from the new key at that bit,
+	// and at the end of the path a bucket for the new key itself
+	Bucket *newbuckets[32];
+	int j;
+	for (j = 0; j < extra; j++) {
+		int bits = depth + j + 1;
+		newbuckets[j] = new_xtndbln_bucket(table,
+			rightmostnbits(bits, hash ^ (1 << (bits - 1))), bits);
+	}
+	newbuckets[extra] = new_xtndbln_bucket(table,
+		rightmostnbits(new_depth, hash), new_depth);
+	table->stats.nbuckets += extra;
+	table->stats.nsplits++;
+	if (new_depth == table->depth) {
+		// the last two buckets use every bit of the table's depth
+		table->ndeep += 2;
+	}
 
+	// FOURTH,
+	// redirect every address that pointed to the old bucket (all prefixes
+	// joined to its first address) to the new bucket covering it
+	int maxprefix = 1 << (table->depth - depth);
 	int prefix;
 	for (prefix = 0; prefix < maxprefix; prefix++) {
-
-		// construct address by joining this prefix and the suffix
-		int a = (prefix << new_depth) | suffix;
-
-		// redirect this table entry to point at the new bucket
-		table->buckets[a] = newbucket;
+		int a = (prefix << depth) | bucket->id;
+		int k = shared_bits(a, hash, depth);
+		dir_set(&table->dir, a, newbuckets[k < extra ? k : extra]);
 	}
 
 	// FINALLY,
-	// filter the key from the old bucket into its rightful place in the new
-	// table (which may be the old bucket, or may be the new bucket)
+	// filter the keys from the old bucket into their rightful place in the new
+	// buckets, keeping their relative order so sorted buckets stay sorted,
+	// and give the old bucket back
+	for (i = 0; i < bucket->nkeys; i++) {
+		int64 key = bucket->keys[i];
+		int k = shared_bits(h1(key), hash, depth);
+		Bucket *to = newbuckets[k < extra ? k : extra];
+		to->keys[to->nkeys++] = key;
+	}
+	slab_release(table->slab, bucket);
+}
+
 
-	int64 *tempkeys = bucket->keys;
+// merge 'bucket' with its buddy (the bucket it was split from, or that was
+// split from it) if both use the same number of hash value bits and their
+// keys fill no more than half a bucket, so that the next few inserts won't
+// split them straight back up
+// returns the merged bucket, or NULL if they could not be merged
+static Bucket *merge_buddies(XtndblNHashTable *table, Bucket *bucket) {
+	int depth = bucket->depth;
+	if (depth == 0) {
+		// this bucket is the whole table
+		return NULL;
+	}
 
-	int num_keys = bucket->nkeys;
+	// the buddy's first address differs in the last bit this bucket uses
+	int bit = 1 << (depth - 1);
+	Bucket *buddy = dir_get(&table->dir, bucket->id ^ bit);
+	if (buddy->depth != depth || bucket->overflow || buddy->overflow
+			|| bucket->nkeys + buddy->nkeys > (table->bucketsize + 1) / 2) {
+		return NULL;
+	}
 
-	bucket->nkeys = 0;
+	// keep the bucket without that bit in its first address, since it is
+	// still the first address of the merged bucket
+	Bucket *keep = bucket, *gone = buddy;
+	if (bucket->id & bit) {
+		keep = buddy;
+		gone = bucket;
+	}
+	bucket_move_keys(table, keep, gone);
+	keep->depth = depth - 1;
+	if (depth == table->depth) {
+		table->ndeep -= 2;
+	}
 
-	// reinsert keys after splitting
-	reinsert_key(table, tempkeys, num_keys);
-}
+	// redirect every address pointing to the removed bucket (all prefixes
+	// joined to its first address, as in splitting) to the merged bucket
+	int maxprefix = 1 << (table->depth - depth);
+	int prefix;
+	for (prefix = 0; prefix < maxprefix; prefix++) {
+		dir_set(&table->dir, (prefix << depth) | gone->id, keep);
+	}
 
+	slab_release(table->slab, gone);
+	table->stats.nbuckets--;
+	return keep;
+}
 
 // insert 'key' into 'table', if it's not in there already
-// returns true if insertion succeeds, false if it was already in there
+// returns true if insertion succeeds, false if it was already in there (or
+// there was no room for it: see 'max_chain' in options.h)
 bool xtndbln_hash_table_insert(XtndblNHashTable *table, int64 key) {
 	assert(table);
 	int start_time = clock(); // start timing
@@ -219,17 +413,36 @@ bool xtndbln_hash_table_insert(XtndblNHashTable *table, int64 key) {
 	int h = h1(key);
 
 	int address = rightmostnbits(table->depth, h);
+	Bucket *bucket = dir_get(&table->dir, address);
 
-	while (table->buckets[address]->nkeys == table->bucketsize){
-		split_xtndbl_table(table, address);
-		//printf("FUCK YOU ASSHOLE\n");
-		// and recalculate address because we might now need more bits
+	if (bucket->nkeys == table->bucketsize && bucket->depth < table->max_depth){
+		split_xtndbl_table(table, address, h);
+		// and recalculate address because we now need more bits
 		address = rightmostnbits(table->depth, h);
+		bucket = dir_get(&table->dir, address);
+	}
+
+	// a full bucket that can't be split any further goes on to the first
+	// bucket in its overflow chain with space, adding one if there isn't one
+	// (unless the chain is already as long as it's allowed to be)
+	int nchained = 0;
+	while (bucket->nkeys == table->bucketsize) {
+		if (!bucket->overflow) {
+			if (nchained == table->max_chain) {
+				table->stats.nrejected++; // no room for it
+				table->stats.time += clock() - start_time; // add time elapsed
+				return false;
+			}
+			bucket->overflow = new_xtndbln_bucket(table, bucket->id,
+				bucket->depth);
+			table->stats.noverflow++;
+		}
+		bucket = bucket->overflow;
+		nchained++;
 	}
 
 	// insert the key
-	table->buckets[address]->keys[table->buckets[address]->nkeys] = key;
-	table->buckets[address]->nkeys++;
+	bucket_add(table, bucket, key);
 	table->stats.nkeys++;
 
 	// add time elapsed to total CPU time before returning
@@ -243,18 +456,140 @@ bool xtndbln_hash_table_insert(XtndblNHashTable *table, int64 key) {
 bool xtndbln_hash_table_lookup(XtndblNHashTable *table, int64 key) {
 	assert(table);
 	int start_time = clock(); // start timing
-	int i, j;
 
-	// linear search through extendible hash table
-	for (i=0; i < table->size; i++){
-		for (j=0; j < table->buckets[i]->nkeys; j++){
-			if(table->buckets[i]->keys[j] == key){
-				return true;
-			}
+	// a key can only be in the bucket its hash value addresses
+	int address = rightmostnbits(table->depth, h1(key));
+	Bucket *bucket = dir_get(&table->dir, address);
+	bool found = bucket_contains(table, bucket, key);
+
+	// add time elapsed to total CPU time before returning result
+	table->stats.time += clock() - start_time;
+	return found;
+}
+
+
+// delete 'key' from 'table', if it's in there
+// returns true if deletion succeeds, false if it wasn't in there
+bool xtndbln_hash_table_delete(XtndblNHashTable *table, int64 key) {
+	assert(table);
+	int start_time = clock(); // start timing
+
+	// a key can only be in the bucket its hash value addresses (or that
+	// bucket's overflow chain)
+	int address = rightmostnbits(table->depth, h1(key));
+	Bucket *bucket = dir_get(&table->dir, address), *node = bucket, *prev = NULL;
+	while (node && !bucket_remove(table, node, key)) {
+		prev = node;
+		node = node->overflow;
+	}
+	if (!node) {
+		table->stats.time += clock() - start_time; // add time elapsed
+		return false;
+	}
+	table->stats.nkeys--;
+
+	// keep the overflow chain as short as possible: every bucket but the last
+	// stays full, so fill the gap with a key from the last bucket, and drop
+	// the last bucket once it's empty
+	if (node->overflow) {
+		prev = node;
+		Bucket *last = node->overflow;
+		while (last->overflow) {
+			prev = last;
+			last = last->overflow;
 		}
+		bucket_add(table, node, last->keys[--last->nkeys]);
+		node = last;
+	}
+	if (node->nkeys == 0 && prev) {
+		prev->overflow = NULL;
+		slab_release(table->slab, node);
+		table->stats.noverflow--;
 	}
+
+	// merge emptied-out buckets back together for as long as possible, then
+	// shrink the directory if no bucket needs all of it any more
+	while (bucket) {
+		bucket = merge_buddies(table, bucket);
+	}
+	xtndbln_halve_table(table);
+
+	// add time elapsed to total CPU time before returning
 	table->stats.time += clock() - start_time;
-	return false;
+	return true;
+}
+
+// insert the 'n' keys in 'keys' into 'table', in order, setting bit i of the
+// bitmap 'results' if keys[i] was inserted (clearing it if already there)
+// returns the number of keys inserted
+int xtndbln_hash_table_insert_batch(XtndblNHashTable *table, int64 *keys,
+	int n, uint8_t *results) {
+	assert(table);
+
+	// prefetch the directory entry of the key BATCH_WINDOW ahead of the one
+	// being inserted
+	int i, ninserted = 0;
+	for (i = 0; i < n && i < BATCH_WINDOW; i++) {
+		dir_prefetch(&table->dir, rightmostnbits(table->depth, h1(keys[i])));
+	}
+	for (i = 0; i < n; i++) {
+		if (i + BATCH_WINDOW < n) {
+			int hash = h1(keys[i + BATCH_WINDOW]);
+			dir_prefetch(&table->dir, rightmostnbits(table->depth, hash));
+		}
+		bool inserted = xtndbln_hash_table_insert(table, keys[i]);
+		bitmap_set(results, i, inserted);
+		ninserted += inserted;
+	}
+
+	return ninserted;
+}
+
+
+// lookup each of the 'n' keys in 'keys', setting bit i of the bitmap
+// 'results' if keys[i] is inside 'table' (clearing it if not)
+// returns the number of keys found
+int xtndbln_hash_table_lookup_batch(XtndblNHashTable *table, int64 *keys,
+	int n, uint8_t *results) {
+	assert(table);
+	int start_time = clock(); // start timing
+
+	// two-stage pipeline: directory entry for the key BATCH_WINDOW ahead,
+	// then bucket for the key half a window ahead (its first keys are
+	// stored inline, so they arrive on the same line as its header)
+	int addresses[BATCH_WINDOW];
+	int half = BATCH_WINDOW / 2;
+	int i, nfound = 0;
+	for (i = 0; i < n && i < BATCH_WINDOW; i++) {
+		addresses[i] = rightmostnbits(table->depth, h1(keys[i]));
+		dir_prefetch(&table->dir, addresses[i]);
+	}
+	for (i = 0; i < n && i < half; i++) {
+		prefetch(dir_get(&table->dir, addresses[i]));
+	}
+
+	for (i = 0; i < n; i++) {
+		if (i + half < n) {
+			prefetch(dir_get(&table->dir, addresses[(i + half) % BATCH_WINDOW]));
+		}
+
+		Bucket *bucket = dir_get(&table->dir, addresses[i % BATCH_WINDOW]);
+
+		if (i + BATCH_WINDOW < n) {
+			int next = rightmostnbits(table->depth, h1(keys[i + BATCH_WINDOW]));
+			addresses[i % BATCH_WINDOW] = next;
+			dir_prefetch(&table->dir, next);
+		}
+
+		// a key can only be in the bucket its hash value addresses
+		bool found = bucket_contains(table, bucket, keys[i]);
+		bitmap_set(results, i, found);
+		nfound += found;
+	}
+
+	// add time elapsed to total CPU time before returning result
+	table->stats.time += clock() - start_time;
+	return nfound;
 }
 
 
@@ -271,22 +606,26 @@ void xtndbln_hash_table_print(XtndblNHashTable *table) {
 	int i;
 	for (i = 0; i < table->size; i++) {
 		// table entry
-		printf("%*d | %-*d ", 9, i, 9, table->buckets[i]->id);
+		Bucket *first = dir_get(&table->dir, i);
+		printf("%*d | %-*d ", 9, i, 9, first->id);
 
 		// if this is the first address at which a bucket occurs, print it now
-		if (table->buckets[i]->id == i) {
-			printf("%*d ", 9, table->buckets[i]->id);
-
-			// print the bucket's contents
-			printf("[");
-			for(int j = 0; j < table->bucketsize; j++) {
-				if (j < table->buckets[i]->nkeys) {
-					printf(" %llu", table->buckets[i]->keys[j]);
-				} else {
-					printf(" -");
+		if (first->id == i) {
+			printf("%*d ", 9, first->id);
+
+			// print the bucket's contents, and those of its overflow chain
+			Bucket *bucket;
+			for (bucket = first; bucket; bucket = bucket->overflow) {
+				printf(bucket == first ? "[" : " -> [");
+				for(int j = 0; j < table->bucketsize; j++) {
+					if (j < bucket->nkeys) {
+						printf(" %llu", bucket->keys[j]);
+					} else {
+						printf(" -");
+					}
 				}
+				printf(" ]");
 			}
-			printf(" ]");
 		}
 		// end the line
 		printf("\n");
@@ -306,11 +645,40 @@ void xtndbln_hash_table_stats(XtndblNHashTable *table) {
 	printf("current table size: %d\n", table->size);
 	printf("    number of keys: %d\n", table->stats.nkeys);
 	printf(" number of buckets: %d\n", table->stats.nbuckets);
+	printf("     bucket splits: %d\n", table->stats.nsplits);
+	printf("  overflow buckets: %d (past depth %d)\n", table->stats.noverflow,
+		table->max_depth);
+	printf("     rejected keys: %d (chains of %d)\n", table->stats.nrejected,
+		table->max_chain);
+	printf("     bucket memory: %.1f KB\n", slab_bytes(table->slab) / 1024.0);
+	printf("  directory memory: %.1f KB%s\n", dir_bytes(&table->dir) / 1024.0,
+		table->dir.lazy ? " (lazy)" : "");
 
 	// also calculate CPU usage in seconds and print this
 	float seconds = table->stats.time * 1.0 / CLOCKS_PER_SEC;
 	printf("    CPU time spent: %.6f sec\n", seconds);
 	printf("        Bucketsize: %d\n", table->bucketsize);
+	if (table->sorted) {
+		printf("     bucket search: sorted, binary search\n");
+	} else {
+		printf("       key compare: %s\n", keys_contain_kernel());
+	}
 
 	printf("--- end stats ---\n");
 }
+
+
+// fill 'stats' with statistics about 'table'
+void xtndbln_hash_table_get_stats(XtndblNHashTable *table, HashStats *stats) {
+	assert(table);
+	init_hash_stats(stats);
+
+	stats->load = table->stats.nkeys;
+	stats->capacity = (long)(table->stats.nbuckets + table->stats.noverflow)
+		* table->bucketsize;
+	stats->memory = slab_bytes(table->slab) + dir_bytes(&table->dir);
+	stats->splits = table->stats.nsplits;
+	stats->resizes = table->stats.nresizes;
+	stats->resize_time = table->stats.resize_time * 1.0 / CLOCKS_PER_SEC;
+	stats->rejected = table->stats.nrejected;
+}
@@ -11,27 +11,51 @@
 
 #include <stdbool.h>
 #include "../inthash.h"
+#include "../options.h"
+#include "../hashstats.h"
 
 typedef struct xtndbln_table XtndblNHashTable;
 
-// initialise an extendible hash table with 'bucketsize' keys per bucket
-XtndblNHashTable *new_xtndbln_hash_table(int bucketsize);
+// initialise an extendible hash table with 'bucketsize' keys per bucket,
+// keeping each bucket's keys sorted if 'options->sorted' is set
+XtndblNHashTable *new_xtndbln_hash_table(int bucketsize, TableOptions *options);
 
 // free all memory associated with 'table'
 void free_xtndbln_hash_table(XtndblNHashTable *table);
 
 // insert 'key' into 'table', if it's not in there already
-// returns true if insertion succeeds, false if it was already in there
+// returns true if insertion succeeds, false if it was already in there (or
+// there was no room for it: see 'max_chain' in options.h)
 bool xtndbln_hash_table_insert(XtndblNHashTable *table, int64 key);
 
+// insert the 'n' keys in 'keys' into 'table', in order, setting bit i of the
+// bitmap 'results' if keys[i] was inserted (clearing it if already there)
+// returns the number of keys inserted
+int xtndbln_hash_table_insert_batch(XtndblNHashTable *table, int64 *keys, int n,
+	uint8_t *results);
+
+// delete 'key' from 'table', if it's in there, merging buckets and shrinking
+// the table as keys are removed
+// returns true if deletion succeeds, false if it wasn't in there
+bool xtndbln_hash_table_delete(XtndblNHashTable *table, int64 key);
+
 // lookup whether 'key' is inside 'table'
 // returns true if found, false if not
 bool xtndbln_hash_table_lookup(XtndblNHashTable *table, int64 key);
 
+// lookup each of the 'n' keys in 'keys', setting bit i of the bitmap
+// 'results' if keys[i] is inside 'table' (clearing it if not)
+// returns the number of keys found
+int xtndbln_hash_table_lookup_batch(XtndblNHashTable *table, int64 *keys, int n,
+	uint8_t *results);
+
 // print the contents of 'table' to stdout
 void xtndbln_hash_table_print(XtndblNHashTable *table);
 
 // print some statistics about 'table' to stdout
 void xtndbln_hash_table_stats(XtndblNHashTable *table);
 
+// fill 'stats' with statistics about 'table'
+void xtndbln_hash_table_get_stats(XtndblNHashTable *table, HashStats *stats);
+
 #endif
\ No newline at end of file
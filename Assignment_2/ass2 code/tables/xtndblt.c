@@ -0,0 +1,566 @@
+/* * * * * * * * *
+ * Dynamic hash table using multi-level extendible hashing: a trie of small
+ * directories, where a directory entry points either at a bucket of keys or
+ * at a sub-directory addressed by the next bits of the hash value, so that
+ * only the part of the hash space that is actually splitting grows
+ *
+ * each directory (a node of the trie) is an ordinary extendible hashing
+ * directory over its own range of hash value bits, doubling as its buckets
+ * split. once a node has NODE_BITS bits, a bucket that needs more bits is
+ * pushed down into a new child node that starts on the next bit, instead of
+ * doubling the whole directory. a skewed set of keys therefore only deepens
+ * the trie where the keys are, and the directory memory stays in proportion
+ * to the number of buckets
+ *
+ * created for COMP20007 Design of Algorithms - Assignment 2, 2017
+ * by Max Philip
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+#include <time.h>
+
+#include "xtndblt.h"
+#include "../batch.h"
+#include "../keysearch.h"
+#include "../slab.h"
+
+// macro to calculate the rightmost n bits of a number x
+#define rightmostnbits(n, x) (x) & ((1 << (n)) - 1)
+
+// most hash value bits a single node of the trie addresses (2^NODE_BITS
+// entries, 8KB of pointers)
+#define NODE_BITS 10
+
+// a directory entry is a pointer to a bucket, or to a child node with its
+// lowest bit set (both are at least 8-byte aligned, so the bit is free)
+#define NODE_TAG ((uintptr_t)1)
+
+// a bucket stores an array of keys, inline after its header
+// it also knows how many of its node's hash value bits are shared between
+// possible keys, and the first address in its node that references it
+typedef struct xtndblt_bucket {
+	int id;			// a unique id for this bucket within its node, equal to
+					// the first address in the node which points to it
+	int depth;		// how many of its node's hash value bits this bucket uses
+	int nkeys;		// number of keys currently contained in this bucket
+	struct xtndblt_bucket *overflow;	// the next bucket in this bucket's
+					// overflow chain (only once it can't split), or NULL
+	int64 keys[];	// the keys stored in this bucket (bucketsize of them)
+} Bucket;
+
+// a node of the trie is a directory of 2^depth entries, addressed by the
+// 'depth' hash value bits from bit 'shift' up (the bits below 'shift' choose
+// the path from the root to this node)
+typedef struct xtndblt_node {
+	int shift;		// how many hash value bits the nodes above this one use
+	int depth;		// how many hash value bits this node uses (log2(size))
+	void **entries;	// 2^depth buckets or (tagged) child nodes
+} Node;
+
+// helper structure to store statistics gathered, taken from xtndbln.c
+typedef struct stats {
+	int nbuckets;	// how many distinct buckets does the table point to
+	int nkeys;		// how many keys are being stored in the table
+	int nsplits;	// how many times a full bucket has been split
+	int noverflow;	// how many overflow buckets are chained to buckets
+	int nnodes;		// how many nodes (directories) make up the trie
+	int nentries;	// how many directory entries there are, over all nodes
+	int time;		// how much CPU time has been used to insert/lookup keys
+					// in this table
+	int nresizes;	// how many times a node's directory has been doubled
+	long resize_time;	// how much of that CPU time was spent doubling them
+	int nrejected;	// how many insertions were refused for want of room
+} Stats;
+
+// a hash table is a trie of directories of pointers to buckets holding up to
+// bucketsize keys, along with some usage statistics
+struct xtndblt_table {
+	Node *root;			// the node addressed by the lowest hash value bits
+	int bucketsize;		// maximum number of keys per bucket
+	int max_depth;		// most hash value bits a bucket can use
+	int max_chain;		// most overflow buckets a bucket can chain on
+	Slab *slab;			// the memory that every bucket is allocated from
+	Stats stats;		// collection of statistics about this hash table
+};
+
+
+/* * * *
+ * helper functions
+ */
+
+// is directory entry 'entry' a child node (rather than a bucket)?
+static inline bool is_node(void *entry) {
+	return (uintptr_t)entry & NODE_TAG;
+}
+
+// the child node that directory entry 'entry' points to
+static inline Node *as_node(void *entry) {
+	return (Node *)((uintptr_t)entry & ~NODE_TAG);
+}
+
+// the directory entry pointing to child node 'node'
+static inline void *node_entry(Node *node) {
+	return (void *)((uintptr_t)node | NODE_TAG);
+}
+
+// create a new bucket in 'table' first referenced from 'first_address' of its
+// node, based on 'depth' of the node's hash value bits
+static Bucket *new_bucket(XtndblTHashTable *table, int first_address,
+		int depth) {
+	Bucket *bucket = slab_alloc(table->slab);
+
+	bucket->id = first_address;
+	bucket->depth = depth;
+	bucket->nkeys = 0;
+	bucket->overflow = NULL;
+
+	return bucket;
+}
+
+// create a new node in 'table', using the hash value bits from 'shift' up,
+// with a single entry pointing to 'bucket'
+static Node *new_node(XtndblTHashTable *table, int shift, Bucket *bucket) {
+	Node *node = malloc(sizeof *node);
+	assert(node);
+	node->entries = malloc(sizeof *node->entries);
+	assert(node->entries);
+
+	node->shift = shift;
+	node->depth = 0;
+	node->entries[0] = bucket;
+	bucket->id = 0;
+	bucket->depth = 0;
+
+	table->stats.nnodes++;
+	table->stats.nentries++;
+	return node;
+}
+
+// free 'node' and all of the nodes below it (but not their buckets)
+static void free_node(Node *node) {
+	int i, size = 1 << node->depth;
+	for (i = 0; i < size; i++) {
+		if (is_node(node->entries[i])) {
+			free_node(as_node(node->entries[i]));
+		}
+	}
+	free(node->entries);
+	free(node);
+}
+
+// double the directory of 'node' in 'table', duplicating the entries in the
+// first half into the new second half
+static void double_node(XtndblTHashTable *table, Node *node) {
+	long start_time = clock();
+	int size = 1 << node->depth;
+	node->entries = realloc(node->entries,
+		(sizeof *node->entries) * size * 2);
+	assert(node->entries);
+	int i;
+	for (i = 0; i < size; i++) {
+		node->entries[size + i] = node->entries[i];
+	}
+	node->depth++;
+	table->stats.nentries += size;
+
+	table->stats.nresizes++;
+	table->stats.resize_time += clock() - start_time;
+}
+
+// find the bucket in 'table' where keys with hash value 'hash' belong,
+// storing the node pointing to it in '*node' and its address there in
+// '*address'
+static Bucket *find_bucket(XtndblTHashTable *table, int hash, Node **node,
+		int *address) {
+	Node *curr = table->root;
+	while (true) {
+		int a = rightmostnbits(curr->depth, hash >> curr->shift);
+		void *entry = curr->entries[a];
+		if (!is_node(entry)) {
+			*node = curr;
+			*address = a;
+			return entry;
+		}
+		curr = as_node(entry);
+	}
+}
+
+// the bucket in 'table' where keys with hash value 'hash' belong
+static Bucket *bucket_for(XtndblTHashTable *table, int hash) {
+	Node *node;
+	int address;
+	return find_bucket(table, hash, &node, &address);
+}
+
+// is 'key' in 'bucket', or in the rest of its overflow chain?
+static bool bucket_contains(Bucket *bucket, int64 key) {
+	for (; bucket; bucket = bucket->overflow) {
+		if (keys_contain(bucket->keys, bucket->nkeys, key)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// split the full bucket at 'address' of 'node' in 'table' by one more hash
+// value bit, first doubling the node or, if it already has NODE_BITS bits,
+// pushing the bucket down into a new child node that uses the next bits
+static void split_bucket(XtndblTHashTable *table, Node *node, int address) {
+	Bucket *bucket = node->entries[address];
+
+	// FIRST,
+	// make sure the node has a bit for the bucket to split on
+	if (bucket->depth == node->depth) {
+		if (node->depth < NODE_BITS) {
+			double_node(table, node);
+		} else {
+			// only this one entry points to the bucket: it becomes a node
+			Node *child = new_node(table, node->shift + node->depth, bucket);
+			node->entries[address] = node_entry(child);
+			node = child;
+			double_node(table, node);
+		}
+	}
+
+	// SECOND,
+	// create a new bucket for the keys with the next bit set, and point the
+	// node's entries with that bit set at it
+	int depth = bucket->depth, bit = 1 << depth;
+	int first_address = bucket->id | bit;
+	Bucket *newbucket = new_bucket(table, first_address, depth + 1);
+	bucket->depth++;
+
+	int a, size = 1 << node->depth;
+	for (a = first_address; a < size; a += 2 * bit) {
+		node->entries[a] = newbucket;
+	}
+
+	// THIRD,
+	// move the keys with the new bit set over to the new bucket
+	int i, nkeys = 0;
+	for (i = 0; i < bucket->nkeys; i++) {
+		int64 key = bucket->keys[i];
+		if ((h1(key) >> node->shift) & bit) {
+			newbucket->keys[newbucket->nkeys++] = key;
+		} else {
+			bucket->keys[nkeys++] = key;
+		}
+	}
+	bucket->nkeys = nkeys;
+	table->stats.nbuckets++;
+	table->stats.nsplits++;
+}
+
+// print 'node' and the nodes below it, indented by 'indent' spaces
+static void print_node(XtndblTHashTable *table, Node *node, int indent) {
+	printf("%*snode: hash bits %d to %d\n", indent, "", node->shift,
+		node->shift + node->depth - 1);
+
+	int i, size = 1 << node->depth;
+	for (i = 0; i < size; i++) {
+		void *entry = node->entries[i];
+
+		// child nodes are printed in full beneath their entry
+		if (is_node(entry)) {
+			printf("%*s%9d | node\n", indent, "", i);
+			print_node(table, as_node(entry), indent + 4);
+			continue;
+		}
+
+		// table entry
+		Bucket *first = entry;
+		printf("%*s%9d | %-9d ", indent, "", i, first->id);
+
+		// if this is the first address at which a bucket occurs, print it now
+		if (first->id == i) {
+			printf("%9d ", first->id);
+
+			// print the bucket's contents, and those of its overflow chain
+			Bucket *bucket;
+			for (bucket = first; bucket; bucket = bucket->overflow) {
+				printf(bucket == first ? "[" : " -> [");
+				int j;
+				for (j = 0; j < table->bucketsize; j++) {
+					if (j < bucket->nkeys) {
+						printf(" %llu", bucket->keys[j]);
+					} else {
+						printf(" -");
+					}
+				}
+				printf(" ]");
+			}
+		}
+		// end the line
+		printf("\n");
+	}
+}
+
+// how many levels deep is the trie below (and including) 'node'?
+static int node_levels(Node *node) {
+	int i, size = 1 << node->depth, levels = 0;
+	for (i = 0; i < size; i++) {
+		if (is_node(node->entries[i])) {
+			int below = node_levels(as_node(node->entries[i]));
+			levels = below > levels ? below : levels;
+		}
+	}
+	return levels + 1;
+}
+
+
+/* * * *
+ * all functions
+ */
+
+// initialise a multi-level extendible hash table with 'bucketsize' keys per
+// bucket, chaining overflow buckets past 'options->max_depth' hash bits
+XtndblTHashTable *new_xtndblt_hash_table(int bucketsize, TableOptions *options){
+	XtndblTHashTable *table = malloc(sizeof *table);
+	assert(table);
+
+	// every bucket is the same size, so they can all come from one slab
+	table->slab = new_slab(sizeof (Bucket) + (sizeof (int64)) * bucketsize);
+	table->bucketsize = bucketsize;
+	table->max_depth = options->max_depth;
+	table->max_chain = options->max_chain;
+
+	// initialise stats
+	table->stats.nbuckets = 1;
+	table->stats.nkeys = 0;
+	table->stats.nsplits = 0;
+	table->stats.noverflow = 0;
+	table->stats.nnodes = 0;
+	table->stats.nentries = 0;
+	table->stats.time = 0;
+	table->stats.nresizes = 0;
+	table->stats.resize_time = 0;
+	table->stats.nrejected = 0;
+
+	table->root = new_node(table, 0, new_bucket(table, 0, 0));
+
+	return table;
+}
+
+
+// free all memory associated with 'table'
+void free_xtndblt_hash_table(XtndblTHashTable *table) {
+	assert(table);
+
+	// the buckets all live in the slab, so they go all at once
+	free_slab(table->slab);
+
+	free_node(table->root);
+	free(table);
+}
+
+
+// insert 'key' into 'table', if it's not in there already
+// returns true if insertion succeeds, false if it was already in there (or
+// there was no room for it: see 'max_chain' in options.h)
+bool xtndblt_hash_table_insert(XtndblTHashTable *table, int64 key) {
+	assert(table);
+	int start_time = clock(); // start timing
+
+	int hash = h1(key);
+	Node *node;
+	int address;
+	Bucket *bucket = find_bucket(table, hash, &node, &address);
+
+	// is this key already there?
+	if (bucket_contains(bucket, key)) {
+		table->stats.time += clock() - start_time; // add time elapsed
+		return false;
+	}
+
+	// if not, split the bucket until it has space for the key (or it uses
+	// as many hash value bits as it's allowed to)
+	while (bucket->nkeys == table->bucketsize
+			&& node->shift + bucket->depth < table->max_depth) {
+		split_bucket(table, node, address);
+
+		// and find the bucket again, as it might be in a new node now
+		bucket = find_bucket(table, hash, &node, &address);
+	}
+
+	// a full bucket that can't be split any further goes on to the first
+	// bucket in its overflow chain with space, adding one if there isn't one
+	// (unless the chain is already as long as it's allowed to be)
+	int nchained = 0;
+	while (bucket->nkeys == table->bucketsize) {
+		if (!bucket->overflow) {
+			if (nchained == table->max_chain) {
+				table->stats.nrejected++; // no room for it
+				table->stats.time += clock() - start_time; // add time elapsed
+				return false;
+			}
+			bucket->overflow = new_bucket(table, bucket->id, bucket->depth);
+			table->stats.noverflow++;
+		}
+		bucket = bucket->overflow;
+		nchained++;
+	}
+
+	// insert the key
+	bucket->keys[bucket->nkeys++] = key;
+	table->stats.nkeys++;
+
+	// add time elapsed to total CPU time before returning
+	table->stats.time += clock() - start_time;
+	return true;
+}
+
+
+// insert the 'n' keys in 'keys' into 'table', in order, setting bit i of the
+// bitmap 'results' if keys[i] was inserted (clearing it if already there)
+// returns the number of keys inserted
+int xtndblt_hash_table_insert_batch(XtndblTHashTable *table, int64 *keys,
+	int n, uint8_t *results) {
+	assert(table);
+
+	// prefetch the root directory entry of the key BATCH_WINDOW ahead of the
+	// one being inserted (the nodes below the root are much smaller, and
+	// more likely to be in cache)
+	Node *root = table->root;
+	int i, ninserted = 0;
+	for (i = 0; i < n && i < BATCH_WINDOW; i++) {
+		prefetch(&root->entries[rightmostnbits(root->depth, h1(keys[i]))]);
+	}
+	for (i = 0; i < n; i++) {
+		if (i + BATCH_WINDOW < n) {
+			int hash = h1(keys[i + BATCH_WINDOW]);
+			prefetch(&root->entries[rightmostnbits(root->depth, hash)]);
+		}
+		bool inserted = xtndblt_hash_table_insert(table, keys[i]);
+		bitmap_set(results, i, inserted);
+		ninserted += inserted;
+	}
+
+	return ninserted;
+}
+
+
+// lookup whether 'key' is inside 'table'
+// returns true if found, false if not
+bool xtndblt_hash_table_lookup(XtndblTHashTable *table, int64 key) {
+	assert(table);
+	int start_time = clock(); // start timing
+
+	// a key can only be in the bucket its hash value leads to
+	bool found = bucket_contains(bucket_for(table, h1(key)), key);
+
+	// add time elapsed to total CPU time before returning result
+	table->stats.time += clock() - start_time;
+	return found;
+}
+
+
+// lookup each of the 'n' keys in 'keys', setting bit i of the bitmap
+// 'results' if keys[i] is inside 'table' (clearing it if not)
+// returns the number of keys found
+int xtndblt_hash_table_lookup_batch(XtndblTHashTable *table, int64 *keys,
+	int n, uint8_t *results) {
+	assert(table);
+	int start_time = clock(); // start timing
+
+	// two-stage pipeline: root directory entry for the key BATCH_WINDOW
+	// ahead, and the bucket or child node it points to for the key half a
+	// window ahead (any walk further down is done when the key gets there)
+	int hashes[BATCH_WINDOW];
+	int half = BATCH_WINDOW / 2;
+	Node *root = table->root;
+	int i, nfound = 0;
+	for (i = 0; i < n && i < BATCH_WINDOW; i++) {
+		hashes[i] = h1(keys[i]);
+		prefetch(&root->entries[rightmostnbits(root->depth, hashes[i])]);
+	}
+
+	for (i = 0; i < n; i++) {
+		if (i + half < n) {
+			int hash = hashes[(i + half) % BATCH_WINDOW];
+			prefetch(as_node(root->entries[rightmostnbits(root->depth, hash)]));
+		}
+
+		int hash = hashes[i % BATCH_WINDOW];
+		if (i + BATCH_WINDOW < n) {
+			int next = h1(keys[i + BATCH_WINDOW]);
+			hashes[i % BATCH_WINDOW] = next;
+			prefetch(&root->entries[rightmostnbits(root->depth, next)]);
+		}
+
+		bool found = bucket_contains(bucket_for(table, hash), keys[i]);
+		bitmap_set(results, i, found);
+		nfound += found;
+	}
+
+	// add time elapsed to total CPU time before returning result
+	table->stats.time += clock() - start_time;
+	return nfound;
+}
+
+
+// print the contents of 'table' to stdout
+void xtndblt_hash_table_print(XtndblTHashTable *table) {
+	assert(table);
+	printf("--- table: %d nodes\n", table->stats.nnodes);
+
+	// print header
+	printf("  table:               buckets:\n");
+	printf("  address | bucketid   bucketid [key]\n");
+
+	// print the trie of nodes, from the root down
+	print_node(table, table->root, 0);
+
+	printf("--- end table ---\n");
+}
+
+
+// print some statistics about 'table' to stdout
+void xtndblt_hash_table_stats(XtndblTHashTable *table) {
+	assert(table);
+
+	printf("--- table stats ---\n");
+
+	// print some stats about state of the table
+	printf("   directory nodes: %d (%d levels, root depth %d)\n",
+		table->stats.nnodes, node_levels(table->root), table->root->depth);
+	printf(" directory entries: %d\n", table->stats.nentries);
+	printf("    number of keys: %d\n", table->stats.nkeys);
+	printf(" number of buckets: %d\n", table->stats.nbuckets);
+	printf("     bucket splits: %d\n", table->stats.nsplits);
+	printf("  overflow buckets: %d (past depth %d)\n", table->stats.noverflow,
+		table->max_depth);
+	printf("     rejected keys: %d (chains of %d)\n", table->stats.nrejected,
+		table->max_chain);
+	printf("     bucket memory: %.1f KB\n", slab_bytes(table->slab) / 1024.0);
+	printf("  directory memory: %.1f KB\n", (table->stats.nnodes * sizeof (Node)
+		+ table->stats.nentries * sizeof (void *)) / 1024.0);
+
+	// also calculate CPU usage in seconds and print this
+	float seconds = table->stats.time * 1.0 / CLOCKS_PER_SEC;
+	printf("    CPU time spent: %.6f sec\n", seconds);
+	printf("        Bucketsize: %d\n", table->bucketsize);
+	printf("       key compare: %s\n", keys_contain_kernel());
+
+	printf("--- end stats ---\n");
+}
+
+
+// fill 'stats' with statistics about 'table'
+void xtndblt_hash_table_get_stats(XtndblTHashTable *table, HashStats *stats) {
+	assert(table);
+	init_hash_stats(stats);
+
+	stats->load = table->stats.nkeys;
+	stats->capacity = (long)(table->stats.nbuckets + table->stats.noverflow)
+		* table->bucketsize;
+	stats->memory = slab_bytes(table->slab)
+		+ (long)table->stats.nnodes * sizeof (Node)
+		+ (long)table->stats.nentries * sizeof (void *);
+	stats->splits = table->stats.nsplits;
+	stats->resizes = table->stats.nresizes;
+	stats->resize_time = table->stats.resize_time * 1.0 / CLOCKS_PER_SEC;
+	stats->rejected = table->stats.nrejected;
+}
@@ -0,0 +1,58 @@
+/* * * * * * * * *
+ * Dynamic hash table using multi-level extendible hashing: a trie of small
+ * directories, where a directory entry points either at a bucket of keys or
+ * at a sub-directory addressed by the next bits of the hash value, so that
+ * only the part of the hash space that is actually splitting grows
+ *
+ * created for COMP20007 Design of Algorithms - Assignment 2, 2017
+ * by Max Philip
+ */
+
+#ifndef XTNDBLT_H
+#define XTNDBLT_H
+
+#include <stdbool.h>
+#include "../inthash.h"
+#include "../options.h"
+#include "../hashstats.h"
+
+typedef struct xtndblt_table XtndblTHashTable;
+
+// initialise a multi-level extendible hash table with 'bucketsize' keys per
+// bucket, chaining overflow buckets past 'options->max_depth' hash bits
+XtndblTHashTable *new_xtndblt_hash_table(int bucketsize, TableOptions *options);
+
+// free all memory associated with 'table'
+void free_xtndblt_hash_table(XtndblTHashTable *table);
+
+// insert 'key' into 'table', if it's not in there already
+// returns true if insertion succeeds, false if it was already in there (or
+// there was no room for it: see 'max_chain' in options.h)
+bool xtndblt_hash_table_insert(XtndblTHashTable *table, int64 key);
+
+// insert the 'n' keys in 'keys' into 'table', in order, setting bit i of the
+// bitmap 'results' if keys[i] was inserted (clearing it if already there)
+// returns the number of keys inserted
+int xtndblt_hash_table_insert_batch(XtndblTHashTable *table, int64 *keys, int n,
+	uint8_t *results);
+
+// lookup whether 'key' is inside 'table'
+// returns true if found, false if not
+bool xtndblt_hash_table_lookup(XtndblTHashTable *table, int64 key);
+
+// lookup each of the 'n' keys in 'keys', setting bit i of the bitmap
+// 'results' if keys[i] is inside 'table' (clearing it if not)
+// returns the number of keys found
+int xtndblt_hash_table_lookup_batch(XtndblTHashTable *table, int64 *keys, int n,
+	uint8_t *results);
+
+// print the contents of 'table' to stdout
+void xtndblt_hash_table_print(XtndblTHashTable *table);
+
+// print some statistics about 'table' to stdout
+void xtndblt_hash_table_stats(XtndblTHashTable *table);
+
+// fill 'stats' with statistics about 'table'
+void xtndblt_hash_table_get_stats(XtndblTHashTable *table, HashStats *stats);
+
+#endif
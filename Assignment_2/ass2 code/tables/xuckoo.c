@@ -11,8 +11,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <time.h>
 
 #include "xuckoo.h"
+#include "../batch.h"
+#include "../slab.h"
+#include "../directory.h"
 
 // macro to calculate the rightmost n bits of a number x
 #define rightmostnbits(n, x) (x) & ((1 << (n)) - 1)
@@ -26,57 +30,205 @@ typedef struct bucket {
 	int depth;	// how many hash value bits are being used by this bucket
 	bool full;	// does this bucket contain a key
 	int64 key;	// the key stored in this bucket
+	struct bucket *overflow;	// the next bucket in this bucket's overflow
+				// chain (only once it can't split), or NULL; every
+				// bucket in a chain is full
 } Bucket;
 
 // an inner table is an extendible hash table with an array of slots pointing
 // to buckets holding up to 1 key, along with some information about the number
 // of hash value bits to use for addressing
 typedef struct inner_table {
-	Bucket **buckets;	// array of pointers to buckets
+	Directory dir;		// table of pointers to buckets, each tagged with
+						// whether its bucket is full and a fingerprint of
+						// the key (see directory.h)
 	int size;			// how many entries in the table of pointers (2^depth)
 	int depth;			// how many bits of the hash value to use (log2(size))
+	int ndeep;			// how many buckets use all 'depth' bits (when there
+						// are none, the table can be halved)
 	int nkeys;			// how many keys are being stored in the table
+	int (*hash)(int64 key);	// the hash function addressing this table
+	int nsplits;		// how many times a bucket has been split
+	int nresizes;		// how many times the table of pointers has been
+						// doubled or halved
+	long resize_time;	// how much CPU time has been spent resizing it
 } InnerTable;
 
-// a xuckoo hash table is just two inner tables for storing inserted keys
+// a xuckoo hash table is just two inner tables for storing inserted keys,
+// plus an overflow stash for any key left over when insertion finds a cycle
 struct xuckoo_table {
 	InnerTable *table1;
 	InnerTable *table2;
+	int load;			// number of keys in the table (including the stash)
+	Slab *slab;			// the memory that both tables' buckets come from
+	int max_depth;		// most hash value bits a bucket can use
+	int max_chain;		// most overflow buckets a bucket can chain on
+	int noverflow;		// how many overflow buckets are chained to buckets
+	int nrejected;		// how many insertions were refused for want of room
+
+	int64 *stash;		// keys that couldn't be placed in either inner table
+	int stash_size;		// how many keys the stash can hold right now
+	int stash_load;		// how many keys are in the stash
+	int nstashed;		// how many keys have been put in the stash
+	int stash_growths;	// how many times the stash has filled up and grown
+	long nevictions;	// how many keys have been swapped out of a bucket
 };
 
 
 bool xuckoo_hash_table_lookup(XuckooHashTable *table, int64 key);
 
 // create a new bucket to contain the new key
-static Bucket *new_bucket(int first_address, int depth) {
-	Bucket *bucket = malloc(sizeof *bucket);
-	assert(bucket);
+static Bucket *new_bucket(XuckooHashTable *table, int first_address,
+		int depth) {
+	Bucket *bucket = slab_alloc(table->slab);
 
 	bucket->id = first_address;
 	bucket->depth = depth;
 	bucket->full = false;
+	bucket->overflow = NULL;
 
 	return bucket;
 }
 
 
+// the directory entry for 'bucket': its pointer, tagged with its key (or
+// untagged, if it has an overflow chain holding other keys too)
+static void *bucket_entry(Bucket *bucket) {
+	if (bucket->overflow) {
+		return dir_untagged_entry(bucket);
+	}
+	return dir_entry(bucket, bucket->full, bucket->key);
+}
+
+// the bucket that address 'address' of inner table 'table' points to
+static Bucket *get_bucket(InnerTable *table, int address) {
+	return entry_pointer(dir_get(&table->dir, address));
+}
+
+// retag the entry of inner table 'table' that a lookup for 'key' reads,
+// after 'bucket' (which that entry points to) has taken 'key' in or given it
+// up. no other entry pointing to the bucket needs its tag kept up to date: a
+// lookup arriving there is for some other key, which can't be in the bucket,
+// and a stale tag only costs it a trip to the bucket to find that out (a
+// bucket with an overflow chain uses every hash value bit, so has one entry)
+static void tag_entry(InnerTable *table, Bucket *bucket, int64 key) {
+	int address = rightmostnbits(table->depth, table->hash(key));
+	dir_retag(&table->dir, address, bucket_entry(bucket));
+}
+
+// does 'bucket', or its overflow chain, hold 'key'?
+static bool bucket_holds(Bucket *bucket, int64 key) {
+	for (; bucket; bucket = bucket->overflow) {
+		if (bucket->full && bucket->key == key) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// how many overflow buckets are chained on 'bucket'?
+static int chain_length(Bucket *bucket) {
+	int nchained = 0;
+	while ((bucket = bucket->overflow)) {
+		nchained++;
+	}
+	return nchained;
+}
+
+// is the bucket of inner table 'inner' that 'key' hashes to full, unable to
+// split any further, and out of room in its overflow chain?
+static bool bucket_stuck(XuckooHashTable *table, InnerTable *inner,
+		int64 key) {
+	Bucket *bucket = get_bucket(inner,
+		rightmostnbits(inner->depth, inner->hash(key)));
+	return bucket->full && bucket->depth == table->max_depth
+		&& chain_length(bucket) == table->max_chain;
+}
+
+// put 'key' in a new overflow bucket at the end of full bucket 'bucket's
+// chain, unless the chain is already as long as it's allowed to be
+// returns true if the key was chained, false if there was no room
+static bool chain_key(XuckooHashTable *table, Bucket *bucket, int64 key) {
+	if (chain_length(bucket) == table->max_chain) {
+		return false;
+	}
+	while (bucket->overflow) {
+		bucket = bucket->overflow;
+	}
+
+	bucket->overflow = new_bucket(table, bucket->id, bucket->depth);
+	bucket->overflow->key = key;
+	bucket->overflow->full = true;
+	table->noverflow++;
+	return true;
+}
+
+// remove 'key' from 'bucket' or its overflow chain, which must hold it,
+// keeping the chain as short as possible: the last bucket in the chain fills
+// the gap with its key, and is dropped
+static void unchain_key(XuckooHashTable *table, Bucket *bucket, int64 key) {
+	Bucket *node = bucket;
+	while (node->key != key) {
+		node = node->overflow;
+	}
+	if (!bucket->overflow) {
+		bucket->full = false;
+		return;
+	}
+
+	Bucket *prev = bucket, *last = bucket->overflow;
+	while (last->overflow) {
+		prev = last;
+		last = last->overflow;
+	}
+	node->key = last->key;
+	prev->overflow = NULL;
+	slab_release(table->slab, last);
+	table->noverflow--;
+}
+
 // double the table of bucket pointers, duplicating the bucket pointers in the
-// first half into the new second half of the table
+// first half into the new second half of the table (or, for a lazy directory,
+// letting the second half stand in for the first until it's written)
 static void double_table(InnerTable *table) {
+	long start_time = clock();
 	int size = table->size * 2;
-	assert(size < MAX_TABLE_SIZE && "error: table has grown too large!");
-
-	// get a new array of twice as many bucket pointers, and copy pointers down
-	table->buckets = realloc(table->buckets, (sizeof *table->buckets) * size);
-	assert(table->buckets);
-	int i;
-	for (i = 0; i < table->size; i++) {
-		table->buckets[table->size + i] = table->buckets[i];
-	}
+	dir_grow(&table->dir, table->depth + 1);
 
 	// finally, increase the table size and the depth we are using to hash keys
+	// (no bucket uses the new bit yet)
 	table->size = size;
 	table->depth++;
+	table->ndeep = 0;
+
+	table->nresizes++;
+	table->resize_time += clock() - start_time;
+}
+
+// halve the table of bucket pointers for as long as no bucket uses the last
+// bit of the hash value: the second half is then just a copy of the first
+static void halve_table(InnerTable *table) {
+	while (table->depth > 0 && table->ndeep == 0) {
+		long start_time = clock();
+		table->size /= 2;
+		table->depth--;
+		dir_shrink(&table->dir, table->depth);
+
+		// count the buckets that use every bit at the new depth, and retag
+		// the entry each key is now looked up at (it may have been in the
+		// half that was dropped)
+		int i;
+		for (i = 0; i < table->size; i++) {
+			Bucket *bucket = get_bucket(table, i);
+			table->ndeep += bucket->id == i && bucket->depth == table->depth;
+			if (bucket->id == i && bucket->full) {
+				tag_entry(table, bucket, bucket->key);
+			}
+		}
+
+		table->nresizes++;
+		table->resize_time += clock() - start_time;
+	}
 }
 
 // reinsert a key into the hash table after splitting a bucket --- we can assume
@@ -85,16 +237,52 @@ static void double_table(InnerTable *table) {
 // use 'xtndbl1_hash_table_insert()' instead for inserting new keys
 static void reinsert_key(XuckooHashTable *table, int64 key, int curr_inner) {
 
-	int address;
-	if (curr_inner == 1){
-		address = rightmostnbits(table->table1->depth, h1(key));
-		table->table1->buckets[address]->key = key;
-		table->table1->buckets[address]->full = true;
-	} else {
-		address = rightmostnbits(table->table2->depth, h2(key));
-		table->table2->buckets[address]->key = key;
-		table->table2->buckets[address]->full = true;
+	InnerTable *inner = curr_inner == 1 ? table->table1 : table->table2;
+	Bucket *bucket = get_bucket(inner,
+		rightmostnbits(inner->depth, inner->hash(key)));
+	bucket->key = key;
+	bucket->full = true;
+	tag_entry(inner, bucket, key);
+}
+
+// put 'key', left over from a cycle, in the stash of 'table', doubling the
+// stash first if it's full (the directories already grow with every split,
+// so there's no whole-table rehash to fall back on)
+static void stash_key(XuckooHashTable *table, int64 key) {
+	if (table->stash_load == table->stash_size) {
+		table->stash_size = table->stash_size > 0 ? table->stash_size * 2 : 1;
+		table->stash = realloc(table->stash,
+			(sizeof *table->stash) * table->stash_size);
+		assert(table->stash);
+		table->stash_growths++;
+	}
+	table->stash[table->stash_load++] = key;
+	table->nstashed++;
+}
+
+// is 'key' in the stash of 'table'?
+static bool in_stash(XuckooHashTable *table, int64 key) {
+	int i;
+	for (i = 0; i < table->stash_load; i++) {
+		if (table->stash[i] == key) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// remove 'key' from the stash of 'table', if it's in there, by moving the
+// last stashed key into its place
+// returns true if it was removed, false if it wasn't there
+static bool unstash_key(XuckooHashTable *table, int64 key) {
+	int i;
+	for (i = 0; i < table->stash_load; i++) {
+		if (table->stash[i] == key) {
+			table->stash[i] = table->stash[--table->stash_load];
+			return true;
+		}
 	}
+	return false;
 }
 
 // split the bucket in 'table' at address 'address', growing table if necessary
@@ -102,7 +290,7 @@ static void split_bucket(XuckooHashTable *main_table, InnerTable *table, int add
 
 	// FIRST,
 	// do we need to grow the table?
-	if (table->buckets[address]->depth == table->depth) {
+	if (get_bucket(table, address)->depth == table->depth) {
 		// yep, this bucket is down to its last pointer
 		double_table(table);
 	}
@@ -110,7 +298,7 @@ static void split_bucket(XuckooHashTable *main_table, InnerTable *table, int add
 
 	// SECOND,
 	// create a new bucket and update both buckets' depth
-	Bucket *bucket = table->buckets[address];
+	Bucket *bucket = get_bucket(table, address);
 	int depth = bucket->depth;
 	int first_address = bucket->id;
 
@@ -119,11 +307,12 @@ static void split_bucket(XuckooHashTable *main_table, InnerTable *table, int add
 
 	// new bucket's first address will be a 1 bit plus the old first address
 	int new_first_address = 1 << depth | first_address;
-	Bucket *newbucket = new_bucket(new_first_address, new_depth);
-	//table->stats.nbuckets++;
+	Bucket *newbucket = new_bucket(main_table, new_first_address, new_depth);
+	table->nsplits++;
 
 	// THIRD,
 	// redirect every second address pointing to this bucket to the new bucket
+	// (which is empty for now)
 	// construct addresses by joining a bit 'prefix' and a bit 'suffix'
 	// (defined below)
 
@@ -143,35 +332,118 @@ static void split_bucket(XuckooHashTable *main_table, InnerTable *table, int add
 		int a = (prefix << new_depth) | suffix;
 
 		// redirect this table entry to point at the new bucket
-		table->buckets[a] = newbucket;
+		dir_set(&table->dir, a, bucket_entry(newbucket));
+	}
+
+	if (new_depth == table->depth) {
+		// both buckets now use every bit of the table's depth
+		table->ndeep += 2;
 	}
 
 	// FINALLY,
 	// filter the key from the old bucket into its rightful place in the new
 	// table (which may be the old bucket, or may be the new bucket)
 
-	// remove and reinsert the key
+	// remove and reinsert the key (which also tags its entry, catching up
+	// with a key swapped into the bucket just before the split)
 	int64 key = bucket->key;
 	bucket->full = false;
 	//table->nkeys--;
 	reinsert_key(main_table, key, curr_inner);
 }
 
+// count the buckets of inner table 'table', by their first addresses
+static int count_buckets(InnerTable *table) {
+	int i, nbuckets = 0;
+	for (i = 0; i < table->size; i++) {
+		nbuckets += get_bucket(table, i)->id == i;
+	}
+	return nbuckets;
+}
+
+// merge 'bucket' of inner table 'table' with its buddy (the bucket it was
+// split from, or that was split from it) if both use the same number of hash
+// value bits and there is at most one key between them
+// returns the merged bucket, or NULL if they could not be merged
+static Bucket *merge_buddies(XuckooHashTable *main_table, InnerTable *table,
+		Bucket *bucket) {
+	int depth = bucket->depth;
+	if (depth == 0) {
+		// this bucket is the whole table
+		return NULL;
+	}
+
+	// the buddy's first address differs in the last bit this bucket uses
+	int bit = 1 << (depth - 1);
+	Bucket *buddy = get_bucket(table, bucket->id ^ bit);
+	if (buddy->depth != depth || bucket->overflow || buddy->overflow
+			|| (bucket->full && buddy->full)) {
+		return NULL;
+	}
+
+	// keep the bucket without that bit in its first address, since it is
+	// still the first address of the merged bucket
+	Bucket *keep = bucket, *gone = buddy;
+	if (bucket->id & bit) {
+		keep = buddy;
+		gone = bucket;
+	}
+	if (gone->full) {
+		keep->key = gone->key;
+		keep->full = true;
+	}
+	keep->depth = depth - 1;
+	if (depth == table->depth) {
+		table->ndeep -= 2;
+	}
+
+	// redirect every address pointing to the removed bucket (all prefixes
+	// joined to its first address, as in splitting) to the merged bucket,
+	// tagged with its key (its own addresses already are, if it had one)
+	int maxprefix = 1 << (table->depth - depth);
+	int prefix;
+	for (prefix = 0; prefix < maxprefix; prefix++) {
+		dir_set(&table->dir, (prefix << depth) | gone->id, bucket_entry(keep));
+	}
+
+	slab_release(main_table->slab, gone);
+	return keep;
+}
 
-// initialise an extendible cuckoo hash table
-XuckooHashTable *new_xuckoo_hash_table() {
+// remove 'key' from 'bucket' (or its overflow chain) of inner table 'table',
+// then merge buckets and halve the table for as long as possible
+static void remove_from_inner(XuckooHashTable *main_table, InnerTable *table,
+		Bucket *bucket, int64 key) {
+	unchain_key(main_table, bucket, key);
+	tag_entry(table, bucket, key);
+	table->nkeys--;
+
+	while (bucket) {
+		bucket = merge_buddies(main_table, table, bucket);
+	}
+	halve_table(table);
+}
+
+
+// initialise an extendible cuckoo hash table, with an overflow stash of
+// 'options->stash_size' keys and lazily growing directories if
+// 'options->lazy_directory' is set, chaining overflow buckets past
+// 'options->max_depth' hash bits
+XuckooHashTable *new_xuckoo_hash_table(TableOptions *options) {
 
 	XuckooHashTable *table = malloc(sizeof *table);
+	assert(table);
+	table->slab = new_slab(sizeof (Bucket));
 
 	// initialise inner tables
 	table->table1 = malloc(sizeof *table->table1);
 	table->table2 = malloc(sizeof *table->table2);
 
-	table->table1->buckets = malloc(sizeof *table->table1->buckets);
-	table->table2->buckets = malloc(sizeof *table->table2->buckets);
+	dir_init(&table->table1->dir, options->lazy_directory);
+	dir_init(&table->table2->dir, options->lazy_directory);
 
-	table->table1->buckets[0] = new_bucket(0, 0);
-	table->table2->buckets[0] = new_bucket(0, 0);
+	dir_set(&table->table1->dir, 0, bucket_entry(new_bucket(table, 0, 0)));
+	dir_set(&table->table2->dir, 0, bucket_entry(new_bucket(table, 0, 0)));
 
 	table->table1->size = 1;
 	table->table2->size = 1;
@@ -179,38 +451,56 @@ XuckooHashTable *new_xuckoo_hash_table() {
 	table->table1->depth = 0;
 	table->table2->depth = 0;
 
+	table->table1->ndeep = 1;
+	table->table2->ndeep = 1;
+
+	table->table1->hash = h1;
+	table->table2->hash = h2;
+
 	table->table1->nkeys = 0;
 	table->table2->nkeys = 0;
+	table->load = 0;
+
+	table->table1->nsplits = table->table2->nsplits = 0;
+	table->table1->nresizes = table->table2->nresizes = 0;
+	table->table1->resize_time = table->table2->resize_time = 0;
+	table->nevictions = 0;
+
+	table->max_depth = options->max_depth;
+	table->max_chain = options->max_chain;
+	table->noverflow = 0;
+	table->nrejected = 0;
+
+	table->stash_size = options->stash_size;
+	table->stash_load = 0;
+	table->nstashed = 0;
+	table->stash_growths = 0;
+	table->stash = malloc((sizeof *table->stash)
+		* (table->stash_size > 0 ? table->stash_size : 1));
+	assert(table->stash);
 	return table;
 }
 
 
 // free all memory associated with 'table'
 void free_xuckoo_hash_table(XuckooHashTable *table) {
-	int i;
-	for (i = table->table1->size-1; i >= 0; i--){
-		if (table->table1->buckets[i]->id == i){
-			free(table->table1->buckets[i]);
-		}
-	}
-	for (i = table->table2->size-1; i >= 0; i--){
-		if (table->table2->buckets[i]->id == i){
-			free(table->table2->buckets[i]);
-		}
-	}
+	// both tables' buckets live in the slab, so they go all at once
+	free_slab(table->slab);
 
-	free(table->table1->buckets);
-	free(table->table2->buckets);
+	dir_free(&table->table1->dir);
+	dir_free(&table->table2->dir);
 
 	free(table->table1);
 	free(table->table2);
+	free(table->stash);
 
 	free(table);
 }
 
 
 // insert 'key' into 'table', if it's not in there already
-// returns true if insertion succeeds, false if it was already in there
+// returns true if insertion succeeds, false if it was already in there (or
+// there was no room for it: see 'max_chain' in options.h)
 bool xuckoo_hash_table_insert(XuckooHashTable *table, int64 key) {
 	//fprintf(stderr, "not yet implemented\n");
 
@@ -241,62 +531,105 @@ bool xuckoo_hash_table_insert(XuckooHashTable *table, int64 key) {
 		return false;
 	}
 
+	// or that there's room for it: when both of its buckets are stuck, all
+	// it could do is evict keys back and forth between them
+	if (bucket_stuck(table, table->table1, key)
+			&& bucket_stuck(table, table->table2, key)) {
+		table->nrejected++; // no room for it
+		return false;
+	}
+
+	// from here on, the key will end up somewhere in the table or the stash
+	table->load++;
+
 	while(true){
 		if (curr_inner == 1){
 			// quit if there is a cycle
 			if ((loop > table->table1->nkeys + table->table2->nkeys ) && (key == curr_key)){
-				printf("\n1CYCLE\n");
 				break;
 			}
 
-			// swap keys if there is one already in there desired location
+			// a full bucket that can't be split any further takes the key on
+			// its overflow chain instead, if there's room
 			address = rightmostnbits(table->table1->depth, h1(key));
-			if (table->table1->buckets[address]->full){
-				temp_key = table->table1->buckets[address]->key;
-				table->table1->buckets[address]->key = key;
+			Bucket *bucket = get_bucket(table->table1, address);
+			if (bucket->full && bucket->depth == table->max_depth
+					&& chain_key(table, bucket, key)) {
+				tag_entry(table->table1, bucket, key);
+				table->table1->nkeys++;
+				return true;
+			}
+
+			// swap keys if there is one already in there desired location
+			if (bucket->full){
+				temp_key = bucket->key;
+				bucket->key = key;
 				key = temp_key;
 				loop++;
+				table->nevictions++;
 			}
 
 			// insert if the bucket is empty
-			if (!table->table1->buckets[address]->full){
-				table->table1->buckets[address]->key = key;
-				table->table1->buckets[address]->full = true;
+			if (!bucket->full){
+				bucket->key = key;
+				bucket->full = true;
+				tag_entry(table->table1, bucket, key);
 				table->table1->nkeys++;
 				return true;
 			}
 
-			// otherwise split
-			split_bucket(table, table->table1, address, curr_inner);
+			// otherwise split, which also tags the key swapped in (a bucket
+			// that can't be split any further just has it tagged)
+			if (bucket->depth < table->max_depth) {
+				split_bucket(table, table->table1, address, curr_inner);
+			} else {
+				tag_entry(table->table1, bucket, bucket->key);
+			}
 			address = rightmostnbits(table->table1->depth, h1(key));
 		}
 
 		if (curr_inner == 2){
 			// quit if there is a cycle
 			if ((loop > table->table2->nkeys + table->table1->nkeys ) && (key == curr_key)){
-				printf("\n2CYCLE\n");
 				break;
 			}
 
-			// swap keys if there is one already in there desired location
+			// a full bucket that can't be split any further takes the key on
+			// its overflow chain instead, if there's room
 			address = rightmostnbits(table->table2->depth, h2(key));
-			if (table->table2->buckets[address]->full){
-				temp_key = table->table2->buckets[address]->key;
-				table->table2->buckets[address]->key = key;
+			Bucket *bucket = get_bucket(table->table2, address);
+			if (bucket->full && bucket->depth == table->max_depth
+					&& chain_key(table, bucket, key)) {
+				tag_entry(table->table2, bucket, key);
+				table->table2->nkeys++;
+				return true;
+			}
+
+			// swap keys if there is one already in there desired location
+			if (bucket->full){
+				temp_key = bucket->key;
+				bucket->key = key;
 				key = temp_key;
 				loop++;
+				table->nevictions++;
 			}
 
 			// insert if the bucket is empty
-			if (!table->table2->buckets[address]->full){
-				table->table2->buckets[address]->key = key;
-				table->table2->buckets[address]->full = true;
+			if (!bucket->full){
+				bucket->key = key;
+				bucket->full = true;
+				tag_entry(table->table2, bucket, key);
 				table->table2->nkeys++;
 				return true;
 			}
 
-			// otherwise split
-			split_bucket(table, table->table2, address, curr_inner);
+			// otherwise split, which also tags the key swapped in (a bucket
+			// that can't be split any further just has it tagged)
+			if (bucket->depth < table->max_depth) {
+				split_bucket(table, table->table2, address, curr_inner);
+			} else {
+				tag_entry(table->table2, bucket, bucket->key);
+			}
 			address = rightmostnbits(table->table2->depth, h2(key));
 		}
 
@@ -307,6 +640,9 @@ bool xuckoo_hash_table_insert(XuckooHashTable *table, int64 key) {
 			curr_inner = 1;
 		}
 	}
+
+	// the key left over from the cycle goes in the stash
+	stash_key(table, key);
 	return true;
 }
 
@@ -321,22 +657,162 @@ bool xuckoo_hash_table_lookup(XuckooHashTable *table, int64 key) {
 	int address1 = rightmostnbits(table->table1->depth, h1(key));
 	int address2 = rightmostnbits(table->table2->depth, h2(key));
 
-	// check both inner tables for the key
-	if (table->table1->buckets[address1]->full){
-		if (table->table1->buckets[address1]->key == key){
+	// check both inner tables for the key, only following the directory
+	// entries that might lead to it
+	void *entry1 = dir_get(&table->table1->dir, address1);
+	void *entry2 = dir_get(&table->table2->dir, address2);
+	if (entry_may_hold(entry1, key)){
+		if (bucket_holds(entry_pointer(entry1), key)){
 			return true;
 		}
 	}
-	if (table->table2->buckets[address2]->full){
-		if (table->table2->buckets[address2]->key == key){
+	if (entry_may_hold(entry2, key)){
+		if (bucket_holds(entry_pointer(entry2), key)){
 			return true;
 		}
 	}
 
-	// add time elapsed to total CPU time before returning result
-	return false;
+	// any key left over from a cycle is in the stash
+	return in_stash(table, key);
+}
+
+// delete 'key' from 'table', if it's in there
+// returns true if deletion succeeds, false if it wasn't in there
+bool xuckoo_hash_table_delete(XuckooHashTable *table, int64 key) {
+	assert(table);
+
+	// calculate table addresses for this key
+	int address1 = rightmostnbits(table->table1->depth, h1(key));
+	int address2 = rightmostnbits(table->table2->depth, h2(key));
+	Bucket *bucket1 = get_bucket(table->table1, address1);
+	Bucket *bucket2 = get_bucket(table->table2, address2);
+
+	// the key could be in either inner table, or the stash
+	if (bucket_holds(bucket1, key)) {
+		remove_from_inner(table, table->table1, bucket1, key);
+	} else if (bucket_holds(bucket2, key)) {
+		remove_from_inner(table, table->table2, bucket2, key);
+	} else if (!unstash_key(table, key)) {
+		return false;
+	}
+
+	table->load--;
+	return true;
+}
+
+// prefetch the directory entries that 'key' hashes to in both inner tables
+static void prefetch_directory(XuckooHashTable *table, int64 key) {
+	dir_prefetch(&table->table1->dir,
+		rightmostnbits(table->table1->depth, h1(key)));
+	dir_prefetch(&table->table2->dir,
+		rightmostnbits(table->table2->depth, h2(key)));
+}
+
+
+// insert the 'n' keys in 'keys' into 'table', in order, setting bit i of the
+// bitmap 'results' if keys[i] was inserted (clearing it if already there)
+// returns the number of keys inserted
+int xuckoo_hash_table_insert_batch(XuckooHashTable *table, int64 *keys, int n,
+	uint8_t *results) {
+	assert(table);
+
+	// prefetch both directory entries of the key BATCH_WINDOW ahead of the
+	// one being inserted
+	int i, ninserted = 0;
+	for (i = 0; i < n && i < BATCH_WINDOW; i++) {
+		prefetch_directory(table, keys[i]);
+	}
+	for (i = 0; i < n; i++) {
+		if (i + BATCH_WINDOW < n) {
+			prefetch_directory(table, keys[i + BATCH_WINDOW]);
+		}
+		bool inserted = xuckoo_hash_table_insert(table, keys[i]);
+		bitmap_set(results, i, inserted);
+		ninserted += inserted;
+	}
+
+	return ninserted;
+}
+
+
+// compute the directory addresses of the 'n' keys in 'keys' in both inner
+// tables (into 'addresses1' and 'addresses2') using the multi-key hash
+// functions, and prefetch the directory entries at those addresses
+static void hash_window(XuckooHashTable *table, int64 *keys, int n,
+	int *addresses1, int *addresses2) {
+	h1_multi(keys, n, addresses1);
+	h2_multi(keys, n, addresses2);
+	int i;
+	for (i = 0; i < n; i++) {
+		addresses1[i] = rightmostnbits(table->table1->depth, addresses1[i]);
+		addresses2[i] = rightmostnbits(table->table2->depth, addresses2[i]);
+		dir_prefetch(&table->table1->dir, addresses1[i]);
+		dir_prefetch(&table->table2->dir, addresses2[i]);
+	}
+}
+
+
+// lookup each of the 'n' keys in 'keys', setting bit i of the bitmap
+// 'results' if keys[i] is inside 'table' (clearing it if not)
+// returns the number of keys found
+int xuckoo_hash_table_lookup_batch(XuckooHashTable *table, int64 *keys, int n,
+	uint8_t *results) {
+	assert(table);
+
+	// hash a whole window of keys at once with the multi-key hash kernels and
+	// prefetch their directory entries, one window ahead of the keys being
+	// probed. then, just before probing a window, prefetch all of its buckets
+	// that the directory entries don't already rule out
+	int addresses1[2][BATCH_WINDOW], addresses2[2][BATCH_WINDOW];
+	int curr = 0;
+	int start, i, nfound = 0;
+	hash_window(table, keys, n < BATCH_WINDOW ? n : BATCH_WINDOW,
+		addresses1[curr], addresses2[curr]);
+
+	for (start = 0; start < n; start += BATCH_WINDOW) {
+		int count = n - start < BATCH_WINDOW ? n - start : BATCH_WINDOW;
+
+		// the directory entries for this window should be in cache by now
+		for (i = 0; i < count; i++) {
+			int64 key = keys[start + i];
+			void *entry1 = dir_get(&table->table1->dir, addresses1[curr][i]);
+			void *entry2 = dir_get(&table->table2->dir, addresses2[curr][i]);
+			if (entry_may_hold(entry1, key)) {
+				prefetch(entry_pointer(entry1));
+			}
+			if (entry_may_hold(entry2, key)) {
+				prefetch(entry_pointer(entry2));
+			}
+		}
+
+		// hash the next window into the other buffers
+		int next = start + BATCH_WINDOW;
+		if (next < n) {
+			int nextcount = n - next < BATCH_WINDOW ? n - next : BATCH_WINDOW;
+			hash_window(table, keys + next, nextcount,
+				addresses1[!curr], addresses2[!curr]);
+		}
+
+		// probe this window
+		for (i = 0; i < count; i++) {
+			void *entry1 = dir_get(&table->table1->dir, addresses1[curr][i]);
+			void *entry2 = dir_get(&table->table2->dir, addresses2[curr][i]);
+			int64 key = keys[start + i];
+			bool found = (entry_may_hold(entry1, key)
+					&& bucket_holds(entry_pointer(entry1), key))
+				|| (entry_may_hold(entry2, key)
+					&& bucket_holds(entry_pointer(entry2), key))
+				|| in_stash(table, key);
+			bitmap_set(results, start + i, found);
+			nfound += found;
+		}
+		curr = !curr;
+	}
+
+	return nfound;
 }
 
+
 // print the contents of 'table' to stdout
 void xuckoo_hash_table_print(XuckooHashTable *table) {
 	assert(table != NULL);
@@ -357,28 +833,95 @@ void xuckoo_hash_table_print(XuckooHashTable *table) {
 		int i;
 		for (i = 0; i < innertables[t]->size; i++) {
 			// table entry
-			printf("%*d | %-*d ", 9, i, 9, innertables[t]->buckets[i]->id);
+			Bucket *bucket = get_bucket(innertables[t], i);
+			printf("%*d | %-*d ", 9, i, 9, bucket->id);
 
 			// if this is the first address at which a bucket occurs, print it
-			if (innertables[t]->buckets[i]->id == i) {
-				printf("%*d ", 9, innertables[t]->buckets[i]->id);
-				if (innertables[t]->buckets[i]->full) {
-					printf("[%llu]", innertables[t]->buckets[i]->key);
+			if (bucket->id == i) {
+				printf("%*d ", 9, bucket->id);
+				if (bucket->full) {
+					printf("[%llu]", bucket->key);
 				} else {
 					printf("[ ]");
 				}
+				while ((bucket = bucket->overflow)) {
+					printf(" -> [%llu]", bucket->key);
+				}
 			}
 
 			// end the line
 			printf("\n");
 		}
 	}
+
+	// keys in the stash don't have an address
+	if (table->stash_load > 0) {
+		printf("stash\n");
+		int i;
+		for (i = 0; i < table->stash_load; i++) {
+			printf("  [%llu]\n", table->stash[i]);
+		}
+	}
 	printf("--- end table ---\n");
 }
 
 
 // print some statistics about 'table' to stdout
 void xuckoo_hash_table_stats(XuckooHashTable *table) {
-	fprintf(stderr, "not yet implemented\n");
-	return;
+	assert(table != NULL);
+	printf("--- table stats ---\n");
+
+	// print some information about each inner table
+	InnerTable *innertables[2] = {table->table1, table->table2};
+	int t;
+	for (t = 0; t < 2; t++) {
+		printf("     table %d: %d entries (depth %d), %d buckets\n", t + 1,
+			innertables[t]->size, innertables[t]->depth,
+			count_buckets(innertables[t]));
+	}
+	printf("current load: %d items\n", table->load);
+	printf("    overflow: %d buckets (past depth %d)\n", table->noverflow,
+		table->max_depth);
+	printf("    rejected: %d keys (chains of %d)\n", table->nrejected,
+		table->max_chain);
+	printf("  bucket mem: %.1f KB\n", slab_bytes(table->slab) / 1024.0);
+	printf("     dir mem: %.1f KB%s\n", (dir_bytes(&table->table1->dir)
+		+ dir_bytes(&table->table2->dir)) / 1024.0,
+		table->table1->dir.lazy ? " (lazy)" : "");
+
+	// and about the stash, and how often it was needed
+	printf("       stash: %d of %d keys\n", table->stash_load,
+		table->stash_size);
+	printf("stashed keys: %d\n", table->nstashed);
+	printf("stash growth: %d (%.3f per 1000 inserts)\n", table->stash_growths,
+		table->load ? table->stash_growths * 1000.0 / table->load : 0);
+
+	printf("--- end stats ---\n");
+}
+
+
+// fill 'stats' with statistics about 'table'
+void xuckoo_hash_table_get_stats(XuckooHashTable *table, HashStats *stats) {
+	assert(table != NULL);
+	init_hash_stats(stats);
+
+	stats->load = table->load;
+	stats->memory = slab_bytes(table->slab)
+		+ (long)table->stash_size * sizeof *table->stash;
+	stats->evictions = table->nevictions;
+	stats->capacity = table->noverflow;
+	stats->rejected = table->nrejected;
+
+	// each bucket holds one key (overflow buckets included, above), and the
+	// rest is summed over both tables
+	InnerTable *innertables[2] = {table->table1, table->table2};
+	int t;
+	for (t = 0; t < 2; t++) {
+		stats->capacity += count_buckets(innertables[t]);
+		stats->memory += dir_bytes(&innertables[t]->dir);
+		stats->splits += innertables[t]->nsplits;
+		stats->resizes += innertables[t]->nresizes;
+		stats->resize_time += innertables[t]->resize_time * 1.0
+			/ CLOCKS_PER_SEC;
+	}
 }
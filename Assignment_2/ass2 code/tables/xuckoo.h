@@ -13,27 +13,51 @@
 
 #include <stdbool.h>
 #include "../inthash.h"
+#include "../options.h"
+#include "../hashstats.h"
 
 typedef struct xuckoo_table XuckooHashTable;
 
-// initialise an extendible cuckoo hash table
-XuckooHashTable *new_xuckoo_hash_table();
+// initialise an extendible cuckoo hash table, with an overflow stash of
+// 'options->stash_size' keys
+XuckooHashTable *new_xuckoo_hash_table(TableOptions *options);
 
 // free all memory associated with 'table'
 void free_xuckoo_hash_table(XuckooHashTable *table);
 
 // insert 'key' into 'table', if it's not in there already
-// returns true if insertion succeeds, false if it was already in there
+// returns true if insertion succeeds, false if it was already in there (or
+// there was no room for it: see 'max_chain' in options.h)
 bool xuckoo_hash_table_insert(XuckooHashTable *table, int64 key);
 
+// insert the 'n' keys in 'keys' into 'table', in order, setting bit i of the
+// bitmap 'results' if keys[i] was inserted (clearing it if already there)
+// returns the number of keys inserted
+int xuckoo_hash_table_insert_batch(XuckooHashTable *table, int64 *keys, int n,
+	uint8_t *results);
+
+// delete 'key' from 'table', if it's in there, merging buckets and shrinking
+// the inner tables as keys are removed
+// returns true if deletion succeeds, false if it wasn't in there
+bool xuckoo_hash_table_delete(XuckooHashTable *table, int64 key);
+
 // lookup whether 'key' is inside 'table'
 // returns true if found, false if not
 bool xuckoo_hash_table_lookup(XuckooHashTable *table, int64 key);
 
+// lookup each of the 'n' keys in 'keys', setting bit i of the bitmap
+// 'results' if keys[i] is inside 'table' (clearing it if not)
+// returns the number of keys found
+int xuckoo_hash_table_lookup_batch(XuckooHashTable *table, int64 *keys, int n,
+	uint8_t *results);
+
 // print the contents of 'table' to stdout
 void xuckoo_hash_table_print(XuckooHashTable *table);
 
 // print some statistics about 'table' to stdout
 void xuckoo_hash_table_stats(XuckooHashTable *table);
 
+// fill 'stats' with statistics about 'table'
+void xuckoo_hash_table_get_stats(XuckooHashTable *table, HashStats *stats);
+
 #endif
@@ -0,0 +1,668 @@
+/* * * * * * * * *
+ * Dynamic hash table using a combination of extendible hashing and cuckoo
+ * hashing with multiple keys per bucket: each key may live in either of two
+ * extendible tables (one per hash function), keys are evicted between them
+ * when both of a key's buckets are full, and a bucket is split only once a
+ * short walk of evictions fails to make room (or, past the deepest a bucket
+ * can go, chains an overflow bucket)
+ *
+ * created for COMP20007 Design of Algorithms - Assignment 2, 2017
+ * by Max Philip
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <time.h>
+
+#include "xuckoon.h"
+#include "../batch.h"
+#include "../keysearch.h"
+#include "../slab.h"
+#include "../directory.h"
+
+// macro to calculate the rightmost n bits of a number x
+#define rightmostnbits(n, x) (x) & ((1 << (n)) - 1)
+
+// how many evictions an insertion may make before giving up and splitting
+// one of its key's buckets instead: unlike plain cuckoo hashing, making room
+// only costs a local split rather than a rehash of the whole table, so a
+// long walk isn't worth it (with 4-key buckets, 8 evictions fill ~91% of
+// slots, against ~79% with none; doubling it buys ~2% for twice the time)
+#define MAX_EVICTIONS 8
+
+
+// a bucket stores an array of keys, inline after its header (as in
+// xtndbln.c), and knows how many bits are shared between possible keys, and
+// the first table address that references it
+typedef struct xuckoon_bucket {
+	int id;			// a unique id for this bucket, equal to the first address
+					// in the table which points to it
+	int depth;		// how many hash value bits are being used by this bucket
+	int nkeys;		// number of keys currently contained in this bucket
+	struct xuckoon_bucket *overflow;	// the next bucket in this bucket's
+					// overflow chain (only once it can't split), or NULL
+	int64 keys[];	// the keys stored in this bucket (bucketsize of them)
+} Bucket;
+
+// an inner table is an extendible hash table with an array of slots pointing
+// to buckets holding up to bucketsize keys, addressed by its own hash function
+typedef struct inner_table {
+	Directory dir;		// table of pointers to buckets
+	int size;			// how many entries in the table of pointers (2^depth)
+	int depth;			// how many bits of the hash value to use (log2(size))
+	int nbuckets;		// how many distinct buckets the table points to
+	int nkeys;			// how many keys are being stored in the table
+	int (*hash)(int64 key);	// the hash function addressing this table
+	int nresizes;		// how many times the table of pointers has doubled
+	long resize_time;	// how much CPU time has been spent doubling it
+} InnerTable;
+
+// helper structure to store statistics gathered
+typedef struct stats {
+	int nsplits;		// how many times a full bucket has been split
+	int nevictions;		// how many keys have been evicted to their other table
+	int noverflow;		// how many overflow buckets are chained to buckets
+	int nrejected;		// how many insertions were refused for want of room
+	int nstashed;		// how many keys have been put in the stash
+	int stash_growths;	// how many times the stash has filled up and grown
+	int time;			// how much CPU time has been used to insert/lookup keys
+						// in this table
+} Stats;
+
+// a bucketized xuckoo hash table is two inner tables for storing inserted
+// keys, plus an overflow stash for any key left over from a walk of
+// evictions that can't be undone (only with overflow chains switched off)
+struct xuckoon_table {
+	InnerTable *table1;
+	InnerTable *table2;
+	int load;			// number of keys in the table (including the stash)
+	int bucketsize;		// maximum number of keys per bucket
+	int max_depth;		// most hash value bits a bucket can use
+	int max_chain;		// most overflow buckets a bucket can chain on
+	Slab *slab;			// the memory that both tables' buckets come from
+
+	int64 *stash;		// keys that couldn't be placed in either inner table
+	int stash_size;		// how many keys the stash can hold right now
+	int stash_load;		// how many keys are in the stash
+	Stats stats;		// collection of statistics about this hash table
+};
+
+
+// create a new bucket in 'table' first referenced from 'first_address', based
+// on 'depth' bits of its keys' hash values
+static Bucket *new_bucket(XuckooNHashTable *table, int first_address,
+		int depth) {
+	Bucket *bucket = slab_alloc(table->slab);
+
+	bucket->id = first_address;
+	bucket->depth = depth;
+	bucket->nkeys = 0;
+	bucket->overflow = NULL;
+
+	return bucket;
+}
+
+// initialise the inner table 'inner' of 'table' with a single empty bucket,
+// addressed by 'hash'
+static void init_inner_table(XuckooNHashTable *table, InnerTable *inner,
+		int (*hash)(int64 key), bool lazy) {
+	dir_init(&inner->dir, lazy);
+	dir_set(&inner->dir, 0, new_bucket(table, 0, 0));
+	inner->size = 1;
+	inner->depth = 0;
+	inner->nbuckets = 1;
+	inner->nkeys = 0;
+	inner->hash = hash;
+	inner->nresizes = 0;
+	inner->resize_time = 0;
+}
+
+// the bucket of inner table 'inner' that 'key' hashes to
+static Bucket *key_bucket(InnerTable *inner, int64 key) {
+	return dir_get(&inner->dir, rightmostnbits(inner->depth, inner->hash(key)));
+}
+
+// is 'key' in 'bucket', or the rest of its overflow chain?
+static bool bucket_contains(Bucket *bucket, int64 key) {
+	for (; bucket; bucket = bucket->overflow) {
+		if (keys_contain(bucket->keys, bucket->nkeys, key)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// the first bucket in 'bucket's overflow chain (starting with 'bucket'
+// itself) with room for another key, or NULL if they're all full
+static Bucket *bucket_with_room(XuckooNHashTable *table, Bucket *bucket) {
+	for (; bucket; bucket = bucket->overflow) {
+		if (bucket->nkeys < table->bucketsize) {
+			return bucket;
+		}
+	}
+	return NULL;
+}
+
+// how many overflow buckets are chained on 'bucket'?
+static int chain_length(Bucket *bucket) {
+	int nchained = 0;
+	while ((bucket = bucket->overflow)) {
+		nchained++;
+	}
+	return nchained;
+}
+
+// add an empty overflow bucket to the end of 'bucket's chain, and return it
+static Bucket *chain_bucket(XuckooNHashTable *table, Bucket *bucket) {
+	while (bucket->overflow) {
+		bucket = bucket->overflow;
+	}
+	bucket->overflow = new_bucket(table, bucket->id, bucket->depth);
+	table->stats.noverflow++;
+	return bucket->overflow;
+}
+
+// double the table of bucket pointers, duplicating the bucket pointers in the
+// first half into the new second half of the table (or, for a lazy directory,
+// letting the second half stand in for the first until it's written)
+static void double_table(InnerTable *inner) {
+	assert(inner->depth < 30 && "error: table has grown too large!");
+	long start_time = clock();
+	dir_grow(&inner->dir, inner->depth + 1);
+	inner->size *= 2;
+	inner->depth++;
+
+	inner->nresizes++;
+	inner->resize_time += clock() - start_time;
+}
+
+// split 'bucket' of inner table 'inner' on the next bit of its keys' hash
+// values, growing the table if necessary
+static void split_bucket(XuckooNHashTable *table, InnerTable *inner,
+		Bucket *bucket) {
+
+	// FIRST,
+	// do we need to grow the table?
+	if (bucket->depth == inner->depth) {
+		// yep, this bucket is down to its last pointer
+		double_table(inner);
+	}
+
+	// SECOND,
+	// create a new bucket for the keys with the new bit set, whose first
+	// address is a 1 bit plus the old first address
+	int depth = bucket->depth;
+	bucket->depth = depth + 1;
+	Bucket *newbucket = new_bucket(table, 1 << depth | bucket->id, depth + 1);
+	inner->nbuckets++;
+	table->stats.nsplits++;
+
+	// THIRD,
+	// redirect every second address pointing to the old bucket (those with
+	// the new bit set) to the new bucket
+	int a;
+	for (a = newbucket->id; a < inner->size; a += 1 << (depth + 1)) {
+		dir_set(&inner->dir, a, newbucket);
+	}
+
+	// FINALLY,
+	// filter the keys from the old bucket into their rightful place, keeping
+	// those without the new bit packed at the front of the old bucket
+	int i, nkeep = 0;
+	for (i = 0; i < bucket->nkeys; i++) {
+		int64 key = bucket->keys[i];
+		if (inner->hash(key) >> depth & 1) {
+			newbucket->keys[newbucket->nkeys++] = key;
+		} else {
+			bucket->keys[nkeep++] = key;
+		}
+	}
+	bucket->nkeys = nkeep;
+}
+
+// put 'key' in the stash of 'table', doubling the stash first if it's full
+// (a walk that gets stuck is undone rather than stashing its key, unless
+// overflow chains are switched off, so it stays small)
+static void stash_key(XuckooNHashTable *table, int64 key) {
+	if (table->stash_load == table->stash_size) {
+		table->stash_size = table->stash_size > 0 ? table->stash_size * 2 : 1;
+		table->stash = realloc(table->stash,
+			(sizeof *table->stash) * table->stash_size);
+		assert(table->stash);
+		table->stats.stash_growths++;
+	}
+	table->stash[table->stash_load++] = key;
+	table->stats.nstashed++;
+}
+
+// is 'key' in the stash of 'table'?
+static bool in_stash(XuckooNHashTable *table, int64 key) {
+	int i;
+	for (i = 0; i < table->stash_load; i++) {
+		if (table->stash[i] == key) {
+			return true;
+		}
+	}
+	return false;
+}
+
+
+// initialise an extendible cuckoo hash table with 'bucketsize' keys per
+// bucket in both inner tables, splitting buckets to at most
+// 'options->max_depth' hash bits and chaining up to 'options->max_chain'
+// overflow buckets on them past that
+XuckooNHashTable *new_xuckoon_hash_table(int bucketsize,
+		TableOptions *options) {
+	XuckooNHashTable *table = malloc(sizeof *table);
+	assert(table);
+
+	// every bucket is the same size, so both tables' buckets can come from
+	// one slab
+	table->slab = new_slab(sizeof (Bucket) + (sizeof (int64)) * bucketsize);
+	table->bucketsize = bucketsize;
+	table->max_depth = options->max_depth;
+	table->max_chain = options->max_chain;
+
+	// initialise inner tables
+	table->table1 = malloc(sizeof *table->table1);
+	table->table2 = malloc(sizeof *table->table2);
+	assert(table->table1 && table->table2);
+	init_inner_table(table, table->table1, h1, options->lazy_directory);
+	init_inner_table(table, table->table2, h2, options->lazy_directory);
+	table->load = 0;
+
+	table->stash_size = options->stash_size;
+	table->stash_load = 0;
+	table->stash = malloc((sizeof *table->stash)
+		* (table->stash_size > 0 ? table->stash_size : 1));
+	assert(table->stash);
+
+	// initialise stats
+	table->stats.nsplits = 0;
+	table->stats.nevictions = 0;
+	table->stats.noverflow = 0;
+	table->stats.nrejected = 0;
+	table->stats.nstashed = 0;
+	table->stats.stash_growths = 0;
+	table->stats.time = 0;
+
+	return table;
+}
+
+
+// free all memory associated with 'table'
+void free_xuckoon_hash_table(XuckooNHashTable *table) {
+	assert(table);
+
+	// both tables' buckets live in the slab, so they go all at once
+	free_slab(table->slab);
+
+	dir_free(&table->table1->dir);
+	dir_free(&table->table2->dir);
+
+	free(table->table1);
+	free(table->table2);
+	free(table->stash);
+
+	free(table);
+}
+
+
+// insert 'key' into 'table', if it's not in there already
+// returns true if insertion succeeds, false if it was already in there (or
+// there was no room for it: see 'max_chain' in options.h)
+bool xuckoon_hash_table_insert(XuckooNHashTable *table, int64 key) {
+	assert(table);
+	int start_time = clock(); // start timing
+
+	// make sure key is not already in the table
+	if (xuckoon_hash_table_lookup(table, key)) {
+		table->stats.time += clock() - start_time; // add time elapsed
+		return false;
+	}
+
+	InnerTable *inners[2] = {table->table1, table->table2};
+	int64 new_key = key;
+	int curr = 0, loop = 0;
+
+	// the slot of each eviction in the current walk (since the last split),
+	// so that a walk that ends with no room for its key can be undone
+	Bucket *walk_buckets[MAX_EVICTIONS];
+	int walk_slots[MAX_EVICTIONS];
+	int nwalked = 0;
+
+	while (true) {
+		// put the key in whichever of its buckets (or their overflow
+		// chains) has room, if either does
+		Bucket *buckets[2] = {key_bucket(inners[0], key),
+			key_bucket(inners[1], key)};
+		int t;
+		for (t = 0; t < 2; t++) {
+			Bucket *room = bucket_with_room(table, buckets[t]);
+			if (room) {
+				room->keys[room->nkeys++] = key;
+				inners[t]->nkeys++;
+				table->load++;
+				table->stats.time += clock() - start_time; // add time elapsed
+				return true;
+			}
+		}
+
+		// both are full: evict a key from one of them to its other table,
+		// alternating tables and taking each slot in turn on successive
+		// visits to the same table
+		if (loop < MAX_EVICTIONS) {
+			Bucket *bucket = buckets[curr];
+			int victim = (loop / 2) % table->bucketsize;
+			int64 evicted = bucket->keys[victim];
+			bucket->keys[victim] = key;
+			key = evicted;
+			walk_buckets[nwalked] = bucket;
+			walk_slots[nwalked++] = victim;
+			table->stats.nevictions++;
+			loop++;
+			curr = !curr;
+			continue;
+		}
+
+		// the walk hasn't made room, so split the shallower of the key's
+		// buckets (the cheaper one to split, and the less likely to double
+		// its table) and try again
+		t = buckets[1]->depth < buckets[0]->depth;
+		if (buckets[t]->depth < table->max_depth) {
+			split_bucket(table, inners[t], buckets[t]);
+			loop = nwalked = 0;
+			continue;
+		}
+
+		// both are as deep as they can go, so chain an overflow bucket for
+		// the key on the one with the shorter chain
+		int lengths[2] = {chain_length(buckets[0]), chain_length(buckets[1])};
+		t = lengths[1] < lengths[0];
+		if (lengths[t] < table->max_chain) {
+			Bucket *overflow = chain_bucket(table, buckets[t]);
+			overflow->keys[overflow->nkeys++] = key;
+			inners[t]->nkeys++;
+			break;
+		}
+
+		// both chains are as long as they can be too: put the walk back the
+		// way it was, and split or chain for the key it started with
+		// instead (one of whose buckets was just split, if it wasn't the
+		// new key, so it has room to split or chain again)
+		if (nwalked > 0) {
+			while (nwalked > 0) {
+				nwalked--;
+				Bucket *bucket = walk_buckets[nwalked];
+				int64 undone = bucket->keys[walk_slots[nwalked]];
+				bucket->keys[walk_slots[nwalked]] = key;
+				key = undone;
+			}
+			continue;
+		}
+
+		// the new key has nowhere to go, so refuse it; any other key (left
+		// over only if overflow chains are switched off) goes in the stash
+		if (key == new_key) {
+			table->stats.nrejected++; // no room for it
+			table->stats.time += clock() - start_time; // add time elapsed
+			return false;
+		}
+		stash_key(table, key);
+		break;
+	}
+	table->load++;
+
+	// add time elapsed to total CPU time before returning
+	table->stats.time += clock() - start_time;
+	return true;
+}
+
+
+// lookup whether 'key' is inside 'table'
+// returns true if found, false if not
+bool xuckoon_hash_table_lookup(XuckooNHashTable *table, int64 key) {
+	assert(table);
+	int start_time = clock(); // start timing
+
+	// the key can only be in its bucket in either inner table, or the stash
+	Bucket *bucket1 = key_bucket(table->table1, key);
+	Bucket *bucket2 = key_bucket(table->table2, key);
+	bool found = bucket_contains(bucket1, key) || bucket_contains(bucket2, key)
+		|| in_stash(table, key);
+
+	// add time elapsed to total CPU time before returning result
+	table->stats.time += clock() - start_time;
+	return found;
+}
+
+
+// prefetch the directory entries that 'key' hashes to in both inner tables
+static void prefetch_directory(XuckooNHashTable *table, int64 key) {
+	dir_prefetch(&table->table1->dir,
+		rightmostnbits(table->table1->depth, h1(key)));
+	dir_prefetch(&table->table2->dir,
+		rightmostnbits(table->table2->depth, h2(key)));
+}
+
+// insert the 'n' keys in 'keys' into 'table', in order, setting bit i of the
+// bitmap 'results' if keys[i] was inserted (clearing it if already there)
+// returns the number of keys inserted
+int xuckoon_hash_table_insert_batch(XuckooNHashTable *table, int64 *keys,
+	int n, uint8_t *results) {
+	assert(table);
+
+	// prefetch both directory entries of the key BATCH_WINDOW ahead of the
+	// one being inserted (splits may redirect them, but most inserts don't
+	// split)
+	int i, ninserted = 0;
+	for (i = 0; i < n && i < BATCH_WINDOW; i++) {
+		prefetch_directory(table, keys[i]);
+	}
+	for (i = 0; i < n; i++) {
+		if (i + BATCH_WINDOW < n) {
+			prefetch_directory(table, keys[i + BATCH_WINDOW]);
+		}
+		bool inserted = xuckoon_hash_table_insert(table, keys[i]);
+		bitmap_set(results, i, inserted);
+		ninserted += inserted;
+	}
+
+	return ninserted;
+}
+
+
+// prefetch both buckets that the directory entries at 'address1' and
+// 'address2' of 'table' point to
+static void prefetch_buckets(XuckooNHashTable *table, int address1,
+		int address2) {
+	prefetch(dir_get(&table->table1->dir, address1));
+	prefetch(dir_get(&table->table2->dir, address2));
+}
+
+// lookup each of the 'n' keys in 'keys', setting bit i of the bitmap
+// 'results' if keys[i] is inside 'table' (clearing it if not)
+// returns the number of keys found
+int xuckoon_hash_table_lookup_batch(XuckooNHashTable *table, int64 *keys,
+	int n, uint8_t *results) {
+	assert(table);
+	int start_time = clock(); // start timing
+
+	// two-stage pipeline: the key BATCH_WINDOW ahead has both of its
+	// directory entries prefetched, then the key half a window ahead (whose
+	// directory entries should be in cache by now) has both of its buckets
+	// prefetched
+	int addresses1[BATCH_WINDOW], addresses2[BATCH_WINDOW];
+	int half = BATCH_WINDOW / 2;
+	int i, nfound = 0;
+	for (i = 0; i < n && i < BATCH_WINDOW; i++) {
+		addresses1[i] = rightmostnbits(table->table1->depth, h1(keys[i]));
+		addresses2[i] = rightmostnbits(table->table2->depth, h2(keys[i]));
+		dir_prefetch(&table->table1->dir, addresses1[i]);
+		dir_prefetch(&table->table2->dir, addresses2[i]);
+	}
+	for (i = 0; i < n && i < half; i++) {
+		prefetch_buckets(table, addresses1[i], addresses2[i]);
+	}
+
+	for (i = 0; i < n; i++) {
+		if (i + half < n) {
+			int ahead = (i + half) % BATCH_WINDOW;
+			prefetch_buckets(table, addresses1[ahead], addresses2[ahead]);
+		}
+
+		int w = i % BATCH_WINDOW;
+		Bucket *bucket1 = dir_get(&table->table1->dir, addresses1[w]);
+		Bucket *bucket2 = dir_get(&table->table2->dir, addresses2[w]);
+
+		if (i + BATCH_WINDOW < n) {
+			int64 next = keys[i + BATCH_WINDOW];
+			addresses1[w] = rightmostnbits(table->table1->depth, h1(next));
+			addresses2[w] = rightmostnbits(table->table2->depth, h2(next));
+			dir_prefetch(&table->table1->dir, addresses1[w]);
+			dir_prefetch(&table->table2->dir, addresses2[w]);
+		}
+
+		int64 key = keys[i];
+		bool found = bucket_contains(bucket1, key)
+			|| bucket_contains(bucket2, key) || in_stash(table, key);
+		bitmap_set(results, i, found);
+		nfound += found;
+	}
+
+	// add time elapsed to total CPU time before returning result
+	table->stats.time += clock() - start_time;
+	return nfound;
+}
+
+
+// print the contents of 'table' to stdout
+void xuckoon_hash_table_print(XuckooNHashTable *table) {
+	assert(table);
+
+	printf("--- table ---\n");
+
+	// loop through the two tables, printing them
+	InnerTable *innertables[2] = {table->table1, table->table2};
+	int t;
+	for (t = 0; t < 2; t++) {
+		// print header
+		printf("table %d\n", t+1);
+
+		printf("  table:               buckets:\n");
+		printf("  address | bucketid   bucketid [key]\n");
+
+		// print table and buckets
+		int i;
+		for (i = 0; i < innertables[t]->size; i++) {
+			// table entry
+			Bucket *bucket = dir_get(&innertables[t]->dir, i);
+			printf("%*d | %-*d ", 9, i, 9, bucket->id);
+
+			// if this is the first address at which a bucket occurs, print it
+			// (and any overflow chain it has)
+			if (bucket->id == i) {
+				printf("%*d ", 9, bucket->id);
+				Bucket *first = bucket;
+				for (; bucket; bucket = bucket->overflow) {
+					printf(bucket == first ? "[" : " -> [");
+					int j;
+					for (j = 0; j < table->bucketsize; j++) {
+						if (j < bucket->nkeys) {
+							printf(" %llu", bucket->keys[j]);
+						} else {
+							printf(" -");
+						}
+					}
+					printf(" ]");
+				}
+			}
+
+			// end the line
+			printf("\n");
+		}
+	}
+
+	// keys in the stash don't have an address
+	if (table->stash_load > 0) {
+		printf("stash\n");
+		int i;
+		for (i = 0; i < table->stash_load; i++) {
+			printf("  [%llu]\n", table->stash[i]);
+		}
+	}
+	printf("--- end table ---\n");
+}
+
+
+// print some statistics about 'table' to stdout
+void xuckoon_hash_table_stats(XuckooNHashTable *table) {
+	assert(table);
+	printf("--- table stats ---\n");
+
+	// print some information about each inner table
+	InnerTable *innertables[2] = {table->table1, table->table2};
+	int t, nbuckets = 0;
+	for (t = 0; t < 2; t++) {
+		printf("     table %d: %d entries (depth %d), %d buckets, %d keys\n",
+			t + 1, innertables[t]->size, innertables[t]->depth,
+			innertables[t]->nbuckets, innertables[t]->nkeys);
+		nbuckets += innertables[t]->nbuckets;
+	}
+	printf("current load: %d items\n", table->load);
+	printf("  bucketsize: %d\n", table->bucketsize);
+	nbuckets += table->stats.noverflow;
+	printf(" bucket fill: %.1f%% of %d slots\n", (table->table1->nkeys
+		+ table->table2->nkeys) * 100.0 / (nbuckets * table->bucketsize),
+		nbuckets * table->bucketsize);
+	printf("    overflow: %d buckets (past depth %d)\n",
+		table->stats.noverflow, table->max_depth);
+	printf("    rejected: %d keys (chains of %d)\n", table->stats.nrejected,
+		table->max_chain);
+	printf("      splits: %d\n", table->stats.nsplits);
+	printf("   evictions: %d (%.3f per insert)\n", table->stats.nevictions,
+		table->load ? table->stats.nevictions * 1.0 / table->load : 0);
+	printf("  bucket mem: %.1f KB\n", slab_bytes(table->slab) / 1024.0);
+	printf("     dir mem: %.1f KB%s\n", (dir_bytes(&table->table1->dir)
+		+ dir_bytes(&table->table2->dir)) / 1024.0,
+		table->table1->dir.lazy ? " (lazy)" : "");
+
+	// and about the stash, and how often it was needed
+	printf("       stash: %d of %d keys\n", table->stash_load,
+		table->stash_size);
+	printf("stashed keys: %d\n", table->stats.nstashed);
+	printf("stash growth: %d\n", table->stats.stash_growths);
+
+	// also calculate CPU usage in seconds and print this
+	float seconds = table->stats.time * 1.0 / CLOCKS_PER_SEC;
+	printf("    CPU time: %.6f sec\n", seconds);
+
+	printf("--- end stats ---\n");
+}
+
+
+// fill 'stats' with statistics about 'table'
+void xuckoon_hash_table_get_stats(XuckooNHashTable *table, HashStats *stats) {
+	assert(table != NULL);
+	init_hash_stats(stats);
+
+	stats->load = table->load;
+	stats->memory = slab_bytes(table->slab)
+		+ (long)table->stash_size * sizeof *table->stash;
+	stats->evictions = table->stats.nevictions;
+	stats->splits = table->stats.nsplits;
+	stats->capacity = (long)table->stats.noverflow * table->bucketsize;
+	stats->rejected = table->stats.nrejected;
+
+	// the rest is summed over both tables
+	InnerTable *innertables[2] = {table->table1, table->table2};
+	int t;
+	for (t = 0; t < 2; t++) {
+		stats->capacity += (long)innertables[t]->nbuckets * table->bucketsize;
+		stats->memory += dir_bytes(&innertables[t]->dir);
+		stats->resizes += innertables[t]->nresizes;
+		stats->resize_time += innertables[t]->resize_time * 1.0
+			/ CLOCKS_PER_SEC;
+	}
+}
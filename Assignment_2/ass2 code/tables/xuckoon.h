@@ -0,0 +1,61 @@
+/* * * * * * * * *
+ * Dynamic hash table using a combination of extendible hashing and cuckoo
+ * hashing with multiple keys per bucket: each key may live in either of two
+ * extendible tables (one per hash function), keys are evicted between them
+ * when both of a key's buckets are full, and a bucket is split only once a
+ * short walk of evictions fails to make room
+ *
+ * created for COMP20007 Design of Algorithms - Assignment 2, 2017
+ * by Max Philip
+ */
+
+#ifndef XUCKOON_H
+#define XUCKOON_H
+
+#include <stdbool.h>
+#include "../inthash.h"
+#include "../options.h"
+#include "../hashstats.h"
+
+typedef struct xuckoon_table XuckooNHashTable;
+
+// initialise an extendible cuckoo hash table with 'bucketsize' keys per
+// bucket in both inner tables, splitting buckets to at most
+// 'options->max_depth' hash bits and chaining up to 'options->max_chain'
+// overflow buckets on them past that
+XuckooNHashTable *new_xuckoon_hash_table(int bucketsize, TableOptions *options);
+
+// free all memory associated with 'table'
+void free_xuckoon_hash_table(XuckooNHashTable *table);
+
+// insert 'key' into 'table', if it's not in there already
+// returns true if insertion succeeds, false if it was already in there (or
+// there was no room for it: see 'max_chain' in options.h)
+bool xuckoon_hash_table_insert(XuckooNHashTable *table, int64 key);
+
+// insert the 'n' keys in 'keys' into 'table', in order, setting bit i of the
+// bitmap 'results' if keys[i] was inserted (clearing it if already there)
+// returns the number of keys inserted
+int xuckoon_hash_table_insert_batch(XuckooNHashTable *table, int64 *keys, int n,
+	uint8_t *results);
+
+// lookup whether 'key' is inside 'table'
+// returns true if found, false if not
+bool xuckoon_hash_table_lookup(XuckooNHashTable *table, int64 key);
+
+// lookup each of the 'n' keys in 'keys', setting bit i of the bitmap
+// 'results' if keys[i] is inside 'table' (clearing it if not)
+// returns the number of keys found
+int xuckoon_hash_table_lookup_batch(XuckooNHashTable *table, int64 *keys, int n,
+	uint8_t *results);
+
+// print the contents of 'table' to stdout
+void xuckoon_hash_table_print(XuckooNHashTable *table);
+
+// print some statistics about 'table' to stdout
+void xuckoon_hash_table_stats(XuckooNHashTable *table);
+
+// fill 'stats' with statistics about 'table'
+void xuckoon_hash_table_get_stats(XuckooNHashTable *table, HashStats *stats);
+
+#endif